@@ -0,0 +1,42 @@
+/* Generated by preparedbc from signals.dbc */
+
+#include "can_signal.h"
+
+#define CAN_SIGNALS_SIZE (240u) /* Bytes of the tables */
+
+#if CAN_SIGNALS_SIZE > CAN_SIGNALS_FLASH_BUDGET
+#error The signal tables are over CAN_SIGNALS_FLASH_BUDGET
+#endif
+
+static const CanSignalMessage signal_messages[] = {
+    /* BodyStatus */
+    {0x00000100u, 0u, 2u},
+    /* EEC1 */
+    {0x8CF004FEu, 2u, 2u},
+    /* ET1 */
+    {0x98FEEEFEu, 4u, 1u},
+    /* CCVS */
+    {0x98FEF1FEu, 5u, 1u},
+};
+
+static const CanSignal signal_list[] = {
+    /* BodyStatus.BatteryVoltage 7|16@0+ (0.01,0) */
+    {0x000000000000FFFFull, 1, 0, 48u, 0x01u, 2u, 2u, "BATTERY", "V"},
+    /* BodyStatus.SteeringAngle 23|16@0- (0.1,0) */
+    {0x000000000000FFFFull, 1, 0, 32u, 0x03u, 4u, 1u, "STEER", "deg"},
+    /* EEC1.ActualEngineTorque 16|8@1+ (1,-125) */
+    {0x00000000000000FFull, 1, -125, 16u, 0x00u, 3u, 0u, "TORQUE", "%"},
+    /* EEC1.EngineSpeed 24|16@1+ (0.125,0) */
+    {0x000000000000FFFFull, 125, 0, 24u, 0x00u, 5u, 3u, "RPM", "rpm"},
+    /* ET1.EngineCoolantTemp 0|8@1+ (1,-40) */
+    {0x00000000000000FFull, 1, -40, 0u, 0x00u, 1u, 0u, "COOLANT", "C"},
+    /* CCVS.WheelBasedVehicleSpeed 8|16@1+ (0.00390625,0) */
+    {0x000000000000FFFFull, 3906, 0, 8u, 0x00u, 3u, 6u, "SPEED", "kmh"},
+};
+
+const CanSignalTables can_signals = {
+    .messages = signal_messages,
+    .messages_count = 4u,
+    .signals = signal_list,
+    .signals_count = 6u,
+};
@@ -0,0 +1,366 @@
+// Compile the signals of a DBC file into the constant tables of can_signal.h
+// License: GPL
+// Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <regex>
+#include <fstream>
+#include <string>
+#include <iostream>
+#include <cmath>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Must match can_signal.h
+static const unsigned SIGNAL_NAME_SIZE = 8;
+static const unsigned SIGNAL_UNIT_SIZE = 4;
+static const unsigned SIGNAL_BIG_ENDIAN = 0x01;
+static const unsigned SIGNAL_SIGNED = 0x02;
+static const unsigned SIGNAL_BYTES = 32;   // sizeof(CanSignal)
+static const unsigned MESSAGE_BYTES = 8;   // sizeof(CanSignalMessage)
+static const unsigned TABLES_BYTES = 16;   // sizeof(CanSignalTables)
+static const unsigned MAX_LENGTH = 32;     // The value is raw * factor in 64 bits
+static const unsigned MAX_DECIMALS = 6;
+
+struct Signal
+{
+    std::string name;
+    std::string label;
+    std::string unit;
+    std::string source;  // The DBC definition for the comment
+    uint64_t mask = 0;
+    int32_t factor = 0;
+    int32_t offset = 0;
+    unsigned shift = 0;
+    unsigned flags = 0;
+    unsigned min_size = 0;
+    unsigned decimals = 0;
+};
+
+struct Message
+{
+    uint32_t key = 0;
+    std::string name;
+    std::vector<Signal> signals;
+};
+
+static std::string baseName(const char* str)
+{
+    const char* slash = strrchr(str, '/');
+    return (slash == nullptr) ? str : (slash + 1);
+}
+
+static bool isWhole(long double value)
+{
+    return std::fabs(value - std::round(value)) <= 1e-9L * std::max(1.0L, std::fabs(value));
+}
+
+// Factor and offset as integers in units of 10^-decimals
+static bool makeFixedPoint(const std::string& name, long double factor, long double offset, Signal& signal)
+{
+    unsigned decimals = 0;
+    long double scale = 1;
+    while ((decimals < MAX_DECIMALS) && !(isWhole(factor * scale) && isWhole(offset * scale)))
+    {
+        decimals++;
+        scale *= 10;
+    }
+    if (!(isWhole(factor * scale) && isWhole(offset * scale)))
+        std::cerr << "Warning: " << name << " factor and offset are rounded to " << MAX_DECIMALS << " decimals" << std::endl;
+
+    while ((std::fabs(factor * scale) > INT32_MAX) || (std::fabs(offset * scale) > INT32_MAX))
+    {
+        if (decimals == 0)
+        {
+            std::cerr << "Skipped " << name << ": factor or offset are out of 32 bits" << std::endl;
+            return false;
+        }
+        decimals--;
+        scale /= 10;
+    }
+
+    signal.factor = (int32_t)std::llround(factor * scale);
+    signal.offset = (int32_t)std::llround(offset * scale);
+    signal.decimals = decimals;
+    if ((signal.factor == 0) && (factor != 0))
+    {
+        std::cerr << "Skipped " << name << ": factor is too small" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Mask and shift over the 64 bit payload word. Motorola signals are in the byte swapped word,
+// where the start bit (the MSB, byte * 8 + bit) is at (7 - byte) * 8 + bit
+static bool makeMask(const std::string& name, unsigned start, unsigned length, bool big_endian, Signal& signal)
+{
+    if ((length == 0) || (length > MAX_LENGTH))
+    {
+        std::cerr << "Skipped " << name << ": " << length << " bits, max " << MAX_LENGTH << std::endl;
+        return false;
+    }
+    int shift;
+    if (big_endian)
+    {
+        const int msb = (7 - (int)(start / 8)) * 8 + (int)(start % 8);
+        shift = msb - (int)(length - 1);
+    }
+    else
+    {
+        shift = (int)start;
+    }
+    if ((start >= 64) || (shift < 0) || (shift + length > 64))
+    {
+        std::cerr << "Skipped " << name << ": out of 8 bytes" << std::endl;
+        return false;
+    }
+    signal.mask = (length == 64) ? UINT64_MAX : ((1ull << length) - 1);
+    signal.shift = (unsigned)shift;
+    signal.min_size = big_endian ? (8 - signal.shift / 8) : ((signal.shift + length - 1) / 8 + 1);
+    if (big_endian)
+        signal.flags |= SIGNAL_BIG_ENDIAN;
+    return true;
+}
+
+static bool loadDbc(const char* fileName, std::vector<Message>& messages)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        std::cerr << "Can't open file " << fileName << std::endl;
+        return false;
+    }
+
+    static const std::regex messageRegex(R"(^\s*BO_\s+(\d+)\s+(\w+)\s*:)");
+    static const std::regex signalRegex(
+        R"(^\s*SG_\s+(\w+)\s*(\w*)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*\(\s*([^,\s]+)\s*,\s*([^)\s]+)\s*\)\s*\[[^\]]*\]\s*\"([^\"]*)\")");
+
+    Message* message = nullptr;
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        std::smatch match;
+        if (std::regex_search(line, match, messageRegex))
+        {
+            const unsigned long id = strtoul(match[1].str().c_str(), nullptr, 10);
+            message = nullptr;
+            // Bit 31 is the extended frame, as in CanIdTableMakeKey. Bits 29 and 30 are pseudo messages
+            if ((id & 0x60000000ul) != 0)
+                continue;
+            messages.emplace_back();
+            message = &messages.back();
+            message->key = (uint32_t)id;
+            message->name = match[2];
+            continue;
+        }
+        if (!std::regex_search(line, match, signalRegex))
+            continue;
+        if (message == nullptr)
+            continue;
+
+        const std::string name = message->name + "." + match[1].str();
+        const std::string multiplexer = match[2];
+        if ((multiplexer.size() > 1) && (multiplexer[0] == 'm'))
+        {
+            std::cerr << "Skipped " << name << ": multiplexed" << std::endl;
+            continue;
+        }
+
+        Signal signal;
+        signal.name = match[1];
+        signal.label = signal.name;
+        signal.unit = match[9];
+        signal.source = std::string(match[3]) + "|" + std::string(match[4]) + "@" + std::string(match[5]) +
+                        std::string(match[6]) + " (" + std::string(match[7]) + "," + std::string(match[8]) + ")";
+        if (match[6] == "-")
+            signal.flags |= SIGNAL_SIGNED;
+        char* end = nullptr;
+        const long double factor = strtold(match[7].str().c_str(), &end);
+        const long double offset = strtold(match[8].str().c_str(), &end);
+        if (!makeMask(name, (unsigned)strtoul(match[3].str().c_str(), nullptr, 10),
+                      (unsigned)strtoul(match[4].str().c_str(), nullptr, 10), match[5] == "0", signal))
+            continue;
+        if (!makeFixedPoint(name, factor, offset, signal))
+            continue;
+        message->signals.push_back(signal);
+    }
+    return true;
+}
+
+// Arguments are Signal or Signal=Label, the label is shown instead of the name
+static bool selectSignals(std::vector<Message>& messages, int argc, char** argv)
+{
+    if (argc == 0)
+        return true;
+
+    std::map<std::string, std::string> labels;
+    for (int i = 0; i < argc; i++)
+    {
+        const char* eq = strchr(argv[i], '=');
+        if (eq == nullptr)
+            labels[argv[i]] = argv[i];
+        else
+            labels[std::string(argv[i], eq - argv[i])] = eq + 1;
+    }
+
+    for (Message& message : messages)
+    {
+        std::vector<Signal> selected;
+        for (Signal& signal : message.signals)
+        {
+            auto i = labels.find(signal.name);
+            if (i == labels.end())
+                continue;
+            signal.label = i->second;
+            selected.push_back(signal);
+            labels.erase(i);
+        }
+        message.signals.swap(selected);
+    }
+
+    for (auto& i : labels)
+        std::cerr << "Signal " << i.first << " is not found" << std::endl;
+    return labels.empty();
+}
+
+static std::string truncate(const std::string& name, unsigned size, const char* what)
+{
+    if (name.size() < size)
+        return name;
+    std::cerr << "Warning: " << what << " " << name << " is truncated to " << (size - 1) << " chars" << std::endl;
+    return name.substr(0, size - 1);
+}
+
+bool PrepareDbc(unsigned long budget, const char* outputFileName, const char* inputFileName, int argc, char** argv)
+{
+    std::vector<Message> messages;
+    if (!loadDbc(inputFileName, messages))
+        return false;
+    if (!selectSignals(messages, argc, argv))
+        return false;
+
+    messages.erase(std::remove_if(messages.begin(), messages.end(),
+                                  [](const Message& message) { return message.signals.empty(); }),
+                   messages.end());
+    std::sort(messages.begin(), messages.end(),
+              [](const Message& a, const Message& b) { return a.key < b.key; });
+    for (size_t i = 1; i < messages.size(); i++)
+    {
+        if (messages[i].key == messages[i - 1].key)
+        {
+            std::cerr << "Duplicate message " << messages[i].key << std::endl;
+            return false;
+        }
+    }
+
+    unsigned long signalsCount = 0;
+    for (const Message& message : messages)
+    {
+        if (message.signals.size() > UINT8_MAX)
+        {
+            std::cerr << "Too many signals in " << message.name << std::endl;
+            return false;
+        }
+        signalsCount += message.signals.size();
+    }
+    if (signalsCount > UINT16_MAX)
+    {
+        std::cerr << "Too many signals" << std::endl;
+        return false;
+    }
+
+    const unsigned long size = messages.size() * MESSAGE_BYTES + signalsCount * SIGNAL_BYTES + TABLES_BYTES;
+    if (size > budget)
+    {
+        std::cerr << "The tables take " << size << " bytes, over the budget of " << budget << std::endl;
+        return false;
+    }
+
+    FILE* fo = fopen(outputFileName, "w");
+    if (!fo)
+    {
+        std::cerr << "Can't create file " << outputFileName << std::endl;
+        return false;
+    }
+
+    fprintf(fo, "/* Generated by preparedbc from %s */\n\n", baseName(inputFileName).c_str());
+    fprintf(fo, "#include \"can_signal.h\"\n\n");
+    fprintf(fo, "#define CAN_SIGNALS_SIZE (%luu) /* Bytes of the tables */\n\n", size);
+    fprintf(fo, "#if CAN_SIGNALS_SIZE > CAN_SIGNALS_FLASH_BUDGET\n");
+    fprintf(fo, "#error The signal tables are over CAN_SIGNALS_FLASH_BUDGET\n");
+    fprintf(fo, "#endif\n\n");
+
+    if (messages.empty())
+    {
+        fprintf(fo, "const CanSignalTables can_signals = {\n");
+        fprintf(fo, "    .messages = NULL,\n");
+        fprintf(fo, "    .messages_count = 0u,\n");
+        fprintf(fo, "    .signals = NULL,\n");
+        fprintf(fo, "    .signals_count = 0u,\n");
+        fprintf(fo, "};\n");
+        fclose(fo);
+        return true;
+    }
+
+    fprintf(fo, "static const CanSignalMessage signal_messages[] = {\n");
+    unsigned first = 0;
+    for (const Message& message : messages)
+    {
+        fprintf(fo, "    /* %s */\n", message.name.c_str());
+        fprintf(fo, "    {0x%08lXu, %uu, %uu},\n", (unsigned long)message.key, first, (unsigned)message.signals.size());
+        first += message.signals.size();
+    }
+    fprintf(fo, "};\n\n");
+
+    fprintf(fo, "static const CanSignal signal_list[] = {\n");
+    for (const Message& message : messages)
+    {
+        for (const Signal& signal : message.signals)
+        {
+            const std::string label = truncate(signal.label, SIGNAL_NAME_SIZE, "Label");
+            const std::string unit = truncate(signal.unit, SIGNAL_UNIT_SIZE, "Unit");
+            fprintf(fo, "    /* %s.%s %s */\n", message.name.c_str(), signal.name.c_str(), signal.source.c_str());
+            fprintf(fo, "    {0x%016llXull, %ld, %ld, %uu, 0x%02Xu, %uu, %uu, \"%s\", \"%s\"},\n",
+                    (unsigned long long)signal.mask, (long)signal.factor, (long)signal.offset, signal.shift,
+                    signal.flags, signal.min_size, signal.decimals, label.c_str(), unit.c_str());
+        }
+    }
+    fprintf(fo, "};\n\n");
+
+    fprintf(fo, "const CanSignalTables can_signals = {\n");
+    fprintf(fo, "    .messages = signal_messages,\n");
+    fprintf(fo, "    .messages_count = %uu,\n", (unsigned)messages.size());
+    fprintf(fo, "    .signals = signal_list,\n");
+    fprintf(fo, "    .signals_count = %luu,\n", signalsCount);
+    fprintf(fo, "};\n");
+
+    fclose(fo);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "preparedbc (c) Alemorf" << std::endl
+                  << "Syntax: " << argv[0] << " budget_bytes output_file.c input_file.dbc [Signal[=Label] ...]" << std::endl
+                  << "Without signals every signal of the file is compiled" << std::endl;
+        return 2;
+    }
+
+    char* end = nullptr;
+    unsigned long budget = strtoul(argv[1], &end, 0);
+    if ((end == nullptr) || (end[0] != '\0') || (budget == 0))
+    {
+        std::cerr << "Incorrect budget = " << argv[1] << std::endl;
+        return 2;
+    }
+
+    return PrepareDbc(budget, argv[2], argv[3], argc - 4, argv + 4) ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Benchmark of can_decoder.c at 1 Mbit/s full load, the decoded frames are checked against the encoded ones
+// License: GPL
+// Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+
+extern "C" {
+#include "can_config.h"
+#include "can_decoder.h"
+}
+
+static const uint32_t CPU_FREQ = 64000000;
+static const uint32_t BITRATE = 1000000;
+static const uint32_t BIT_TIME = CPU_FREQ / BITRATE;  // CPU ticks of the target
+static const unsigned FRAMES = 2000;                   // Different frames, replayed back to back
+static const unsigned REPEATS = 500;                  // Default
+
+struct Frame
+{
+    uint32_t id = 0;
+    bool extended = false;
+    unsigned dlc = 0;
+    uint8_t data[8] = {};
+};
+
+// Bits of the frames as they are on the bus, 0 = dominant
+class Encoder
+{
+public:
+    std::vector<uint8_t> bits;
+
+    // SOF to the end of intermission, the next SOF follows at once
+    void add(const Frame& frame)
+    {
+        crc = 0;
+        same = 0;
+        last = 2;
+        stuffed(0);  // SOF
+        if (frame.extended)
+        {
+            field(frame.id >> 18, 11);
+            field(3, 2);  // SRR, IDE
+            field(frame.id & 0x3FFFF, 18);
+            field(0, 3);  // RTR, r1, r0
+        }
+        else
+        {
+            field(frame.id, 11);
+            field(0, 3);  // RTR, IDE, r0
+        }
+        field(frame.dlc, 4);
+        for (unsigned i = 0; i < frame.dlc; i++)
+            field(frame.data[i], 8);
+        const uint16_t frameCrc = crc;
+        field(frameCrc, 15);
+        bits.push_back(1);  // CRC delimiter
+        bits.push_back(0);  // ACK slot
+        bits.insert(bits.end(), 1 + 7 + 3, 1);  // ACK delimiter, EOF, intermission
+    }
+
+private:
+    uint16_t crc = 0;
+    unsigned same = 0;
+    unsigned last = 2;
+
+    void stuffed(unsigned bit)
+    {
+        const unsigned next = bit ^ (crc >> 14);
+        crc = (uint16_t)((crc << 1) & 0x7FFF);
+        if ((next & 1) != 0)
+            crc ^= 0x4599;
+        bits.push_back((uint8_t)bit);
+        same = (bit == last) ? (same + 1) : 1;
+        last = bit;
+        if (same == 5)
+        {
+            bits.push_back((uint8_t)!bit);
+            last = !bit;
+            same = 1;
+        }
+    }
+
+    void field(uint32_t value, unsigned count)
+    {
+        for (unsigned i = count; i > 0; i--)
+            stuffed((value >> (i - 1)) & 1);
+    }
+};
+
+// As CanCaptureRead returns them, starting with the falling edge of the first SOF
+static std::vector<CanEdge> makeEdges(const std::vector<uint8_t>& bits, uint32_t start)
+{
+    std::vector<CanEdge> edges;
+    uint8_t level = 1;
+    for (size_t i = 0; i < bits.size(); i++)
+    {
+        if (bits[i] != level)
+        {
+            level = bits[i];
+            edges.push_back(CanEdgeMake(start + (uint32_t)i * BIT_TIME, level != 0));
+        }
+    }
+    return edges;
+}
+
+struct Result
+{
+    std::vector<Frame> frames;
+    unsigned index = 0;
+    unsigned mismatches = 0;
+};
+
+static void onFrame(void* context, const CanDecodedFrame* decoded)
+{
+    Result& result = *(Result*)context;
+    const Frame& frame = result.frames[result.index % result.frames.size()];
+    if ((decoded->id != frame.id) || (decoded->dlc != frame.dlc) ||
+        (((decoded->flags & CAN_DECODED_FRAME_EXTENDED) != 0) != frame.extended) ||
+        ((decoded->flags & (CAN_DECODED_FRAME_CRC_ERROR | CAN_DECODED_FRAME_NO_ACK)) != 0))
+        result.mismatches++;
+    result.index++;
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned repeats = (argc > 1) ? (unsigned)atoi(argv[1]) : REPEATS;
+    Result result;
+    Encoder encoder;
+    srand(1);
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        Frame frame;
+        frame.extended = (rand() % 4) == 0;
+        frame.id = frame.extended ? ((uint32_t)rand() & 0x1FFFFFFF) : ((uint32_t)rand() & 0x7FF);
+        frame.dlc = (unsigned)(rand() % 9);
+        for (unsigned j = 0; j < frame.dlc; j++)
+            frame.data[j] = (uint8_t)rand();
+        encoder.add(frame);
+        result.frames.push_back(frame);
+    }
+    const std::vector<CanEdge> edges = makeEdges(encoder.bits, 0);
+    const uint32_t repeatTime = (uint32_t)encoder.bits.size() * BIT_TIME;
+
+    CanDecoder decoder;
+    CanDecoderInit(&decoder, BIT_TIME, onFrame, &result);
+    // The decoder finds SOF after 11 recessive bits
+    const CanEdge idle = CanEdgeMake(0, true);
+    CanDecoderAddEdges(&decoder, &idle, 1);
+    uint32_t offset = 11 * BIT_TIME;
+    std::vector<CanEdge> shifted(edges.size());
+    double seconds = 0;
+    for (unsigned repeat = 0; repeat < repeats; repeat++)
+    {
+        // The same frames later in time, the time wraps as DWT->CYCCNT does
+        for (size_t i = 0; i < edges.size(); i++)
+            shifted[i] = edges[i] + offset;
+        offset += repeatTime;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < shifted.size(); i += CAN_CAPTURE_READ_BATCH)
+        {
+            const size_t count = (shifted.size() - i < CAN_CAPTURE_READ_BATCH) ? (shifted.size() - i)
+                                                                               : CAN_CAPTURE_READ_BATCH;
+            CanDecoderAddEdges(&decoder, &shifted[i], count);
+        }
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    CanDecoderFlush(&decoder, offset);
+
+    const uint64_t frames = (uint64_t)FRAMES * repeats;
+    const double bits = (double)encoder.bits.size() * repeats;
+    std::cout << "can_decoder_bench: " << decoder.frames << " of " << frames << " frames, " << result.mismatches
+              << " mismatches, " << (uint64_t)(frames / seconds) << " frames/s, " << seconds * 1e9 / bits
+              << " ns per bit, " << bits / BITRATE / seconds << " times 1 Mbit/s" << std::endl;
+    const bool ok = (decoder.frames == frames) && (result.mismatches == 0) && (decoder.crc_errors == 0) &&
+                    (decoder.stuff_errors == 0) && (decoder.form_errors == 0) && (decoder.error_frames == 0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// Benchmark of can_id_table.c with millions of synthetic frames. The identifier sets share their low bits as real
+// buses do, none of them may evict while the table has free slots
+// License: GPL
+// Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <stdint.h>
+
+extern "C" {
+#include "can_config.h"
+#include "can_hash.h"
+#include "can_id_table.h"
+}
+
+static const unsigned FRAMES = 4000000;
+static const uint32_t FRAME_TIME = 128 * 111;  // CPU ticks of a 111 bit frame at 500 kbit/s
+static const unsigned MAX_IDS = CAN_ID_TABLE_SIZE * 3 / 4;
+
+static unsigned failures = 0;
+
+struct IdSet
+{
+    std::string name;
+    std::vector<uint32_t> keys;
+};
+
+static std::vector<IdSet> makeIdSets()
+{
+    std::vector<IdSet> sets(4);
+    sets[0].name = "multiples of 0x20";
+    for (uint32_t i = 0; i < MAX_IDS; i++)
+        sets[0].keys.push_back(CanIdTableMakeKey(0x20 + i * 0x20, false));
+    sets[1].name = "J1939 PGNs of SA 0x00";
+    for (uint32_t i = 0; i < MAX_IDS; i++)
+        sets[1].keys.push_back(CanIdTableMakeKey(0x18000000 | ((0xFE00 + i * 0x11) << 8), true));
+    sets[2].name = "CANopen COB-IDs";
+    static const uint32_t functions[] = {0x180, 0x200, 0x280, 0x300, 0x380, 0x400, 0x480, 0x500, 0x580, 0x600, 0x700};
+    for (uint32_t node = 1; sets[2].keys.size() < MAX_IDS; node++)
+        for (uint32_t function : functions)
+            if (sets[2].keys.size() < MAX_IDS)
+                sets[2].keys.push_back(CanIdTableMakeKey(function + node, false));
+    sets[3].name = "consecutive";
+    for (uint32_t i = 0; i < MAX_IDS; i++)
+        sets[3].keys.push_back(CanIdTableMakeKey(0x100 + i, false));
+    return sets;
+}
+
+static void bench(const IdSet& set)
+{
+    for (size_t i = 0; i < set.keys.size(); i++)
+        for (size_t j = 0; j < i; j++)
+            if (set.keys[i] == set.keys[j])
+                std::cerr << set.name << ": duplicate key" << std::endl;
+
+    static CanIdTable table;
+    CanIdTableInit(&table);
+    uint64_t time = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        CanIdTableAdd(&table, set.keys[i % set.keys.size()], time, 8, 111);
+        time += FRAME_TIME;
+    }
+    const double addSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto findStart = std::chrono::steady_clock::now();
+    unsigned found = 0;
+    for (unsigned i = 0; i < FRAMES; i++)
+        found += (CanIdTableFind(&table, set.keys[i % set.keys.size()]) != nullptr) ? 1 : 0;
+    const double findSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - findStart).count();
+
+    // Distance of each entry from its home slot
+    unsigned maxProbes = 0;
+    unsigned probes = 0;
+    for (uint32_t i = 0; i < CAN_ID_TABLE_SIZE; i++)
+    {
+        const uint32_t key = table.entries[i].key;
+        if (key != CAN_ID_TABLE_EMPTY)
+        {
+            const unsigned distance = (i - CanHash(key, CAN_ID_TABLE_SIZE)) & (CAN_ID_TABLE_SIZE - 1);
+            probes += distance + 1;
+            maxProbes = (distance + 1 > maxProbes) ? (distance + 1) : maxProbes;
+        }
+    }
+
+    std::cout << "can_id_table_bench: " << set.name << ", " << set.keys.size() << " ids: "
+              << addSeconds * 1e9 / FRAMES << " ns per add, " << findSeconds * 1e9 / FRAMES << " ns per find, "
+              << (double)probes / (table.count ? table.count : 1) << " probes average, " << maxProbes << " max, "
+              << table.evictions << " evictions" << std::endl;
+    if ((table.evictions != 0) || (table.count != set.keys.size()) || (found != FRAMES))
+    {
+        std::cerr << "FAILED: " << set.name << std::endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    for (const IdSet& set : makeIdSets())
+        bench(set);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,382 @@
+// Replay of captured edge buffers through the batch consumer of can_load.h, and of the raw TIM2 CCR1/CCR2 DMA
+// rings through CanCaptureRead of can_capture_stm32f1xx.c
+// License: GPL
+// Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+
+extern "C" {
+#include "can_config.h"
+#include "can_load.h"
+#include "can_capture.h"
+#include "stm32f1xx_hal.h"
+}
+
+DWT_Type host_dwt;
+CoreDebug_Type host_core_debug;
+TIM_TypeDef host_tim2;
+DMA_TypeDef host_dma1;
+DMA_Channel_TypeDef host_dma1_channel5;
+DMA_Channel_TypeDef host_dma1_channel7;
+AFIO_TypeDef host_afio;
+
+static const uint32_t BIT_TIME = 64000000 / 500000;               // CPU ticks at 500 kbit/s
+static const uint32_t PAYLOAD_TIME = BIT_TIME * CAN_PAYLOAD_BITS;
+static const uint32_t START_TIME = 0xFFFF0000u;                    // DWT->CYCCNT wraps during the replay
+
+static unsigned failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// As CanCaptureRead returns them: multiples of CAN_CAPTURE_PRESCALER, both directions in time order
+struct Capture
+{
+    std::vector<CanEdge> edges;
+    uint32_t time = START_TIME;
+    uint32_t expected_active = 0;  // Of the falling edge periods, as can_load.h defines it
+    uint32_t expected_inactive = 0;
+    uint32_t falling_edges = 0;
+    bool has_falling = false;
+    uint32_t last_falling = 0;
+
+    void add(uint32_t low_bits, uint32_t high_bits)
+    {
+        const uint32_t falling = time;
+        if (has_falling)
+        {
+            const uint32_t period = falling - last_falling;
+            expected_active += (period < PAYLOAD_TIME) ? period : PAYLOAD_TIME;
+            expected_inactive += (period < PAYLOAD_TIME) ? 0 : (period - PAYLOAD_TIME);
+        }
+        has_falling = true;
+        last_falling = falling;
+        falling_edges++;
+        edges.push_back(CanEdgeMake(falling, false));
+        time += low_bits * BIT_TIME;
+        edges.push_back(CanEdgeMake(time, true));
+        time += high_bits * BIT_TIME;
+    }
+};
+
+// Frames of 1..5 bit runs separated by the idle bus, the layout is random but reproducible
+static Capture makeCapture(unsigned frames)
+{
+    Capture capture;
+    srand(1);
+    for (unsigned i = 0; i < frames; i++)
+    {
+        const unsigned runs = 20 + (unsigned)(rand() % 30);
+        for (unsigned j = 0; j < runs; j++)
+            capture.add(1 + (unsigned)(rand() % 5), 1 + (unsigned)(rand() % 5));
+        capture.add(1, 11 + (unsigned)(rand() % 200));  // ACK slot, EOF, intermission and idle
+    }
+    return capture;
+}
+
+static void replay(CanLoad& load, const std::vector<CanEdge>& edges, size_t batch)
+{
+    for (size_t i = 0; i < edges.size(); i += batch)
+    {
+        const size_t count = (edges.size() - i < batch) ? (edges.size() - i) : batch;
+        CanLoadAddEdges(&load, &edges[i], count);
+    }
+}
+
+static void testBatches()
+{
+    const Capture capture = makeCapture(1000);
+    check(CanEdgeTime(capture.edges.front()) > CanEdgeTime(capture.edges.back()), "the replay crosses the wrap");
+
+    // Every batch size gives the same result, the state is carried between the reads
+    static const size_t batches[] = {1, 2, 7, CAN_CAPTURE_READ_BATCH, CAN_CAPTURE_BUFFER_SIZE};
+    for (size_t batch : batches)
+    {
+        CanLoad load;
+        CanLoadInit(&load, PAYLOAD_TIME);
+        replay(load, capture.edges, batch);
+        check(load.edges == capture.falling_edges, "falling edges");
+        check(load.active_time == capture.expected_active, "active time");
+        check(load.inactive_time == capture.expected_inactive, "inactive time");
+    }
+
+    // The batch consumer matches the interrupt handler path
+    CanLoad single;
+    CanLoadInit(&single, PAYLOAD_TIME);
+    for (CanEdge edge : capture.edges)
+        if (!CanEdgeIsRising(edge))
+            CanLoadAddEdge(&single, CanEdgeTime(edge));
+    check(single.active_time == capture.expected_active, "single edges");
+}
+
+static void testResync()
+{
+    // Lost edges: the period over the gap is not counted
+    const Capture capture = makeCapture(10);
+    CanLoad load;
+    CanLoadInit(&load, PAYLOAD_TIME);
+    const size_t half = capture.edges.size() / 2;
+    CanLoadAddEdges(&load, capture.edges.data(), half);
+    const uint32_t active = load.active_time;
+    const uint32_t inactive = load.inactive_time;
+    CanLoadResync(&load);
+    CanLoadAddEdges(&load, &capture.edges[half], 1);
+    check((load.active_time == active) && (load.inactive_time == inactive), "resync");
+}
+
+// Edges from a text file, a line per edge: the time in CPU ticks and R or F
+static const uint32_t TIMER_WRAP = 0x10000u * CAN_CAPTURE_PRESCALER;  // CPU ticks
+static const uint32_t FALLING_LATENCY = 3 * CAN_CAPTURE_PRESCALER;    // The DMA of CCR1 transfers later than CCR2
+static const uint32_t MAX_READ_INTERVAL = 150000;                       // CPU ticks, less than a ring of edges
+
+// TIM2 and both DMA channels: an edge is captured into CCRx as a 16-bit timer value and transferred into the ring
+// after the latency of its channel, the DMA raises HT and TC and counts CNDTR down from the buffer size
+struct Device
+{
+    struct Ring
+    {
+        uint16_t* buffer;
+        DMA_Channel_TypeDef* channel;
+        uint32_t halfFlag;
+        uint32_t fullFlag;
+        uint32_t latency;
+        uint32_t position;
+    };
+
+    CanCapture capture;
+    uint32_t startTime;
+    Ring falling;
+    Ring rising;
+    std::vector<CanEdge> read;
+
+    explicit Device(uint32_t time) : startTime(time)
+    {
+        setTime(time);
+        CanCaptureInit(&capture);
+        clearFlags();
+        falling = {capture.falling.buffer, DMA1_Channel5, DMA_ISR_HTIF5, DMA_ISR_TCIF5, FALLING_LATENCY, 0};
+        rising = {capture.rising.buffer, DMA1_Channel7, DMA_ISR_HTIF7, DMA_ISR_TCIF7, 0, 0};
+    }
+
+    void setTime(uint32_t time)
+    {
+        host_dwt.CYCCNT = time;
+        host_tim2.CNT = (uint16_t)((time - startTime) / CAN_CAPTURE_PRESCALER);
+    }
+
+    // A read writes IFCR with the flags of each channel it has seen, nothing is transferred during a read here
+    static void clearFlags()
+    {
+        host_dma1.ISR = 0;
+    }
+
+    void transfer(CanEdge edge)
+    {
+        Ring& ring = CanEdgeIsRising(edge) ? rising : falling;
+        ring.buffer[ring.position] = (uint16_t)((CanEdgeTime(edge) - startTime) / CAN_CAPTURE_PRESCALER);
+        ring.position++;
+        if (ring.position == CAN_CAPTURE_BUFFER_SIZE / 2)
+            host_dma1.ISR |= ring.halfFlag;
+        if (ring.position == CAN_CAPTURE_BUFFER_SIZE)
+        {
+            ring.position = 0;
+            host_dma1.ISR |= ring.fullFlag;
+        }
+        ring.channel->CNDTR = CAN_CAPTURE_BUFFER_SIZE - ring.position;
+    }
+
+    // Reads as ReadEdges of my.c does, till the capture is empty. Returns true when edges were lost
+    bool readAt(uint32_t time)
+    {
+        setTime(time);
+        CanEdge edges[CAN_CAPTURE_READ_BATCH];
+        size_t count = 0;
+        do
+        {
+            count = CanCaptureRead(&capture, edges, CAN_CAPTURE_READ_BATCH);
+            clearFlags();
+            read.insert(read.end(), edges, edges + count);
+        } while (count != 0);
+        return CanCaptureTakeLost(&capture);
+    }
+};
+
+// Time since the start, the times wrap
+static uint32_t since(const Device& device, uint32_t time)
+{
+    return time - device.startTime;
+}
+
+// Every edge is transferred at its time plus the latency of its channel, the reads come at random times and right
+// after the spikes, when the rising edge of a spike is in the ring and its falling edge is not yet
+static void testCapture()
+{
+    std::vector<CanEdge> edges = makeCapture(1000).edges;
+
+    // Spikes of a timer tick inside the recessive runs, younger than CAN_CAPTURE_HOLDBACK when read
+    std::vector<uint32_t> spikeReads;
+    for (size_t i = 1; i < edges.size(); i += 50)
+    {
+        if (CanEdgeIsRising(edges[i]))
+        {
+            const uint32_t spike = CanEdgeTime(edges[i]) + BIT_TIME / 2;
+            edges.insert(edges.begin() + (long)i + 1, CanEdgeMake(spike, false));
+            edges.insert(edges.begin() + (long)i + 2, CanEdgeMake(spike + CAN_CAPTURE_PRESCALER, true));
+            spikeReads.push_back(spike + 2 * CAN_CAPTURE_PRESCALER);
+        }
+    }
+
+    // The idle bus of several timer wraps in the middle, the timer extension is by DWT
+    const uint32_t idle = 3 * TIMER_WRAP + TIMER_WRAP / 2;
+    for (size_t i = edges.size() / 2; i < edges.size(); i++)
+        edges[i] = CanEdgeMake(CanEdgeTime(edges[i]) + idle, CanEdgeIsRising(edges[i]));
+
+    Device device(START_TIME);
+    const uint32_t end = since(device, CanEdgeTime(edges.back())) + TIMER_WRAP / 4;
+    std::vector<uint32_t> reads;
+    for (uint32_t read = 0; read < end; read += 1 + (uint32_t)(rand() % MAX_READ_INTERVAL))
+        reads.push_back(read);
+    for (uint32_t spikeRead : spikeReads)
+        reads.push_back(since(device, spikeRead));
+    reads.push_back(end);
+    std::sort(reads.begin(), reads.end());
+
+    size_t nextFalling = 0;
+    size_t nextRising = 0;
+    bool lost = false;
+    for (uint32_t read : reads)
+    {
+        // Each channel transfers in time order
+        for (;;)
+        {
+            while ((nextFalling < edges.size()) && CanEdgeIsRising(edges[nextFalling]))
+                nextFalling++;
+            while ((nextRising < edges.size()) && !CanEdgeIsRising(edges[nextRising]))
+                nextRising++;
+            if ((nextFalling < edges.size()) &&
+                (since(device, CanEdgeTime(edges[nextFalling])) + device.falling.latency <= read))
+                device.transfer(edges[nextFalling++]);
+            else if ((nextRising < edges.size()) &&
+                     (since(device, CanEdgeTime(edges[nextRising])) + device.rising.latency <= read))
+                device.transfer(edges[nextRising++]);
+            else
+                break;
+        }
+        lost |= device.readAt(device.startTime + read);
+    }
+
+    check(!lost && (device.capture.overruns == 0), "capture without losses");
+    check(device.read == edges, "capture edges in time order");
+    check(CanEdgeTime(edges.front()) > CanEdgeTime(edges.back()), "the capture crosses the DWT wrap");
+
+    // And the load of the read edges is the load of the edges
+    CanLoad expected;
+    CanLoad captured;
+    CanLoadInit(&expected, PAYLOAD_TIME);
+    CanLoadInit(&captured, PAYLOAD_TIME);
+    replay(expected, edges, CAN_CAPTURE_READ_BATCH);
+    replay(captured, device.read, CAN_CAPTURE_READ_BATCH);
+    check(captured.active_time == expected.active_time, "capture active time");
+}
+
+// More edges between two reads than a ring holds: HT and TC can't be explained by CNDTR, the read drops both
+// rings and the capture goes on with the next edges
+static void testCaptureOverrun()
+{
+    static const uint32_t extra[] = {0, 10, CAN_CAPTURE_BUFFER_SIZE / 2};
+    for (uint32_t count : extra)
+    {
+        Device device(START_TIME);
+        uint32_t time = START_TIME + BIT_TIME;
+        for (uint32_t i = 0; i < CAN_CAPTURE_BUFFER_SIZE + count; i++)
+        {
+            device.transfer(CanEdgeMake(time, false));
+            time += BIT_TIME;
+        }
+        device.transfer(CanEdgeMake(time, true));
+        check(device.readAt(time + BIT_TIME) && device.read.empty() && (device.capture.overruns == 1), "overrun");
+
+        const CanEdge next[] = {CanEdgeMake(time + 2 * BIT_TIME, false), CanEdgeMake(time + 3 * BIT_TIME, true)};
+        device.transfer(next[0]);
+        device.transfer(next[1]);
+        check(!device.readAt(time + 4 * BIT_TIME) && (device.read == std::vector<CanEdge>(next, next + 2)),
+              "capture after the overrun");
+    }
+
+    // Half a ring twice between the reads is not an overrun
+    Device device(START_TIME);
+    uint32_t time = START_TIME + BIT_TIME;
+    for (uint32_t read = 0; read < 4; read++)
+    {
+        for (uint32_t i = 0; i < CAN_CAPTURE_BUFFER_SIZE / 2; i++)
+        {
+            device.transfer(CanEdgeMake(time, false));
+            time += BIT_TIME;
+        }
+        check(!device.readAt(time), "half ring reads");
+    }
+    check(device.read.size() == 2 * CAN_CAPTURE_BUFFER_SIZE, "half ring edges");
+}
+
+// A read later than the timer wrap can't place the unread edges, without edges it only extends the time
+static void testCaptureLate()
+{
+    Device device(START_TIME);
+    uint32_t time = START_TIME + 5 * TIMER_WRAP / 2;
+    check(!device.readAt(time), "late read without edges");
+    device.transfer(CanEdgeMake(time + BIT_TIME, false));
+    check(!device.readAt(time + 2 * BIT_TIME) && (device.read.size() == 1) &&
+              (CanEdgeTime(device.read[0]) == time + BIT_TIME),
+          "edge after the idle wraps");
+
+    device.transfer(CanEdgeMake(time + 3 * BIT_TIME, true));
+    check(device.readAt(time + 3 * BIT_TIME + TIMER_WRAP) && (device.read.size() == 1), "late read with edges");
+}
+
+static bool replayFile(const char* fileName)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        std::cerr << "Can't open file " << fileName << std::endl;
+        return false;
+    }
+    std::vector<CanEdge> edges;
+    uint32_t time = 0;
+    char direction = 0;
+    while (file >> time >> direction)
+        edges.push_back(CanEdgeMake(time, direction == 'R'));
+
+    CanLoad load;
+    CanLoadInit(&load, PAYLOAD_TIME);
+    replay(load, edges, CAN_CAPTURE_READ_BATCH);
+    const uint64_t total = (uint64_t)load.active_time + load.inactive_time;
+    const uint64_t percent = (total == 0) ? 0 : ((uint64_t)load.active_time * 100 / total);
+    std::cout << load.edges << " falling edges, load " << percent << "%" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        return replayFile(argv[1]) ? 0 : 1;
+
+    testBatches();
+    testResync();
+    testCapture();
+    testCaptureOverrun();
+    testCaptureLate();
+    std::cout << "can_load_replay: " << ((failures == 0) ? "OK" : "FAILED") << std::endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+// Test of the 64-bit CPU cycle timebase of delay_cpu_cycles.h over the DWT->CYCCNT wraps. The reads are
+// interrupted by the SysTick update between the epoch and DWT->CYCCNT loads, as it happens on the target
+// License: GPL
+// Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+
+#include <iostream>
+#include <random>
+#include <stdint.h>
+
+extern "C" {
+#include "delay_cpu_cycles.h"
+}
+
+DWT_Type host_dwt;
+CoreDebug_Type host_core_debug;
+
+static const uint64_t WRAP = 1ull << 32;
+static const unsigned READS = 4;                // Per SysTick period
+static const uint32_t MAX_INTERRUPTION = 1024;  // CPU ticks between the two loads of a read
+
+static unsigned failures = 0;
+static std::mt19937_64 random64(1);
+
+static void check(bool ok, const char* what, uint64_t time)
+{
+    if (!ok)
+    {
+        if (failures < 10)
+            std::cerr << "FAILED: " << what << " at " << time << std::endl;
+        failures++;
+    }
+}
+
+// DWT->CYCCNT is the low word of the true time
+static void setTime(uint64_t time)
+{
+    host_dwt.CYCCNT = (uint32_t)time;
+}
+
+// GetCpuCycles64 with SysTick between the loads: the epoch is loaded at epochTime, DWT->CYCCNT at cyclesTime
+static uint64_t interruptedRead(uint64_t epochTime, uint64_t cyclesTime, uint64_t sysTickTime)
+{
+    setTime(epochTime);
+    const uint32_t epoch = cpu_cycles_epoch;
+    if ((sysTickTime > epochTime) && (sysTickTime <= cyclesTime))
+    {
+        setTime(sysTickTime);
+        UpdateCpuCycles64();
+    }
+    setTime(cyclesTime);
+    return MakeCpuCycles64(epoch, DWT->CYCCNT);
+}
+
+// SysTick every period, the reads in between come in time order
+static void testPeriod(uint64_t period, uint64_t end)
+{
+    setTime(0);
+    EnableDwt();
+    uint64_t last = 0;
+    for (uint64_t tick = 0; tick < end; tick += period)
+    {
+        setTime(tick);
+        UpdateCpuCycles64();
+        uint64_t time = tick;
+        for (unsigned i = 0; i < READS; i++)
+        {
+            time += random64() % ((period / READS) - MAX_INTERRUPTION);
+            const uint64_t cyclesTime = time + random64() % MAX_INTERRUPTION;
+            // The next SysTick may come during the read, the epoch is restored so it is not updated in the past
+            const uint32_t epoch = cpu_cycles_epoch;
+            const uint64_t result = interruptedRead(time, cyclesTime, tick + period);
+            cpu_cycles_epoch = epoch;
+            check(result == cyclesTime, "exact", cyclesTime);
+            check(result >= last, "monotonic", cyclesTime);
+            last = result;
+            time = cyclesTime;
+        }
+        setTime(tick + period - 1);
+        check(GetCpuCycles64() == tick + period - 1, "uninterrupted", tick + period - 1);
+    }
+}
+
+static void testExtend()
+{
+    for (unsigned i = 0; i < 1000000; i++)
+    {
+        const uint64_t now = random64() >> 8;
+        const uint64_t age = random64() % WRAP;
+        if (age <= now)
+            check(ExtendCpuCycles(now, (uint32_t)(now - age)) == now - age, "extend", now);
+    }
+}
+
+int main()
+{
+    testPeriod(64000, 3 * WRAP + WRAP / 2);              // 1 ms, the SysTick rate
+    testPeriod(64000000, 5 * WRAP);                     // 1 s
+    testPeriod((1ull << 31) - MAX_INTERRUPTION, 9 * WRAP);  // The slowest allowed update, 33 s
+    testExtend();
+    std::cout << "cpu_cycles64_test: " << ((failures == 0) ? "OK" : "FAILED") << std::endl;
+    return (failures == 0) ? 0 : 1;
+}
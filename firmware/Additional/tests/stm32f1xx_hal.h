@@ -0,0 +1,98 @@
+// Host stand-in for the registers used by delay_cpu_cycles.h and can_capture_stm32f1xx.c
+// License: GPL
+// Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+
+#ifndef ADDITIONAL_TESTS_STM32F1XX_HAL_H_
+#define ADDITIONAL_TESTS_STM32F1XX_HAL_H_
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_core_debug;
+
+#define DWT (&host_dwt)
+#define CoreDebug (&host_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk (1u)
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24u)
+
+// The test plays the timer and the DMA: CNT, the CCRx ring contents, CNDTR and the ISR flags.
+// A write of IFCR only stores the value, the test clears the ISR flags after a read
+typedef struct {
+    volatile uint32_t CR1;
+    volatile uint32_t DIER;
+    volatile uint32_t SR;
+    volatile uint32_t EGR;
+    volatile uint32_t CCMR1;
+    volatile uint32_t CCER;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+} TIM_TypeDef;
+
+typedef struct {
+    volatile uint32_t ISR;
+    volatile uint32_t IFCR;
+} DMA_TypeDef;
+
+typedef struct {
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+    volatile uint32_t MAPR;
+} AFIO_TypeDef;
+
+extern TIM_TypeDef host_tim2;
+extern DMA_TypeDef host_dma1;
+extern DMA_Channel_TypeDef host_dma1_channel5;
+extern DMA_Channel_TypeDef host_dma1_channel7;
+extern AFIO_TypeDef host_afio;
+
+#define TIM2 (&host_tim2)
+#define DMA1 (&host_dma1)
+#define DMA1_Channel5 (&host_dma1_channel5)
+#define DMA1_Channel7 (&host_dma1_channel7)
+#define AFIO (&host_afio)
+
+#define __HAL_RCC_TIM2_CLK_ENABLE()
+#define __HAL_RCC_DMA1_CLK_ENABLE()
+
+#define DMA_ISR_HTIF5 (1u << 18u)
+#define DMA_ISR_TCIF5 (1u << 17u)
+#define DMA_ISR_HTIF7 (1u << 26u)
+#define DMA_ISR_TCIF7 (1u << 25u)
+#define DMA_CCR_EN (1u << 0u)
+#define DMA_CCR_CIRC (1u << 5u)
+#define DMA_CCR_MINC (1u << 7u)
+#define DMA_CCR_PSIZE_0 (1u << 8u)
+#define DMA_CCR_MSIZE_0 (1u << 10u)
+#define DMA_CCR_PL_1 (1u << 13u)
+#define TIM_CR1_CEN (1u << 0u)
+#define TIM_DIER_CC1DE (1u << 9u)
+#define TIM_DIER_CC2DE (1u << 10u)
+#define TIM_EGR_UG (1u << 0u)
+#define TIM_CCMR1_CC1S_0 (1u << 0u)
+#define TIM_CCMR1_CC2S_1 (1u << 9u)
+#define TIM_CCER_CC1E (1u << 0u)
+#define TIM_CCER_CC1P (1u << 1u)
+#define TIM_CCER_CC2E (1u << 4u)
+#define AFIO_MAPR_TIM2_REMAP (3u << 8u)
+#define AFIO_MAPR_TIM2_REMAP_PARTIALREMAP1 (1u << 8u)
+#define AFIO_MAPR_SWJ_CFG (7u << 24u)
+#define AFIO_MAPR_SWJ_CFG_JTAGDISABLE (2u << 24u)
+
+#endif /* ADDITIONAL_TESTS_STM32F1XX_HAL_H_ */
@@ -0,0 +1,115 @@
+/* CAN bit rate detection from RX edge timestamps
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_autobaud.h"
+#include <assert.h>
+#include <string.h>
+
+#define CAN_AUTOBAUD_RUNS (512u)                                /* About 15 frames */
+#define CAN_AUTOBAUD_MIN_RUNS (CAN_AUTOBAUD_RUNS / 16u)        /* Fewer are glitches */
+#define CAN_AUTOBAUD_TOLERANCE_SHIFT (2u)                       /* +-25% of the bit time */
+#define CAN_AUTOBAUD_MIN_WIDTH_PERCENT (25u)                    /* Of the fastest bit time, shorter are glitches */
+#define CAN_AUTOBAUD_BATCH (32u)                                /* Edges filtered on the stack at once */
+
+static const uint32_t can_autobaud_rates[CAN_AUTOBAUD_RATES_COUNT] = {1000000u, 500000u, 250000u, 125000u};
+
+static void CanAutobaudRestart(CanAutobaud *self) {
+    (void)memset(self->counts, 0, sizeof(self->counts));
+    self->runs = 0u;
+}
+
+void CanAutobaudInit(CanAutobaud *self, uint32_t cpu_freq) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_AUTOBAUD_RATES_COUNT; i++) {
+        self->bit_times[i] = cpu_freq / can_autobaud_rates[i];
+    }
+    CanGlitchInit(&self->glitch, self->bit_times[0], CAN_AUTOBAUD_MIN_WIDTH_PERCENT);
+    self->candidate = 0u;
+    self->result = 0u;
+    CanAutobaudResync(self);
+    CanAutobaudRestart(self);
+}
+
+void CanAutobaudResync(CanAutobaud *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    CanGlitchResync(&self->glitch);
+    self->prev_time_valid = false;
+}
+
+/* A single window does not restart the controller, a burst of noise can match a rate once */
+static void CanAutobaudDecide(CanAutobaud *self) {
+    uint32_t rate = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_AUTOBAUD_RATES_COUNT; i++) {
+        if (self->counts[i] >= CAN_AUTOBAUD_MIN_RUNS) {
+            rate = can_autobaud_rates[i];
+            break;
+        }
+    }
+    if ((rate != 0u) && (rate == self->candidate)) {
+        self->result = rate;
+    }
+    self->candidate = rate;
+    CanAutobaudRestart(self);
+}
+
+static void CanAutobaudAddFiltered(CanAutobaud *self, const CanEdge edges[], size_t count) {
+    size_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        const uint32_t time = CanEdgeTime(edges[i]);
+        if (self->prev_time_valid) {
+            const uint32_t period = time - self->prev_time;
+            uint32_t j = 0u;
+            for (j = 0u; j < CAN_AUTOBAUD_RATES_COUNT; j++) {
+                const uint32_t bit_time = self->bit_times[j];
+                const uint32_t tolerance = bit_time >> CAN_AUTOBAUD_TOLERANCE_SHIFT;
+                if (period < (bit_time - tolerance)) {
+                    break; /* Shorter than any bit, a glitch */
+                }
+                if (period <= (bit_time + tolerance)) {
+                    self->counts[j]++;
+                    break;
+                }
+            }
+            self->runs++;
+            if (self->runs == CAN_AUTOBAUD_RUNS) {
+                CanAutobaudDecide(self);
+            }
+        }
+        self->prev_time = time;
+        self->prev_time_valid = true;
+    }
+}
+
+void CanAutobaudAddEdges(CanAutobaud *self, const CanEdge edges[], size_t count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((edges != NULL) || (count == 0u));
+
+    /* The filter works in place, the caller's edges go on to the measurement filter */
+    CanEdge batch[CAN_AUTOBAUD_BATCH];
+    size_t start = 0u;
+    while (start < count) {
+        const size_t size = ((count - start) < CAN_AUTOBAUD_BATCH) ? (count - start) : CAN_AUTOBAUD_BATCH;
+        (void)memcpy(batch, &edges[start], size * sizeof(batch[0]));
+        CanAutobaudAddFiltered(self, batch, CanGlitchFilter(&self->glitch, batch, size));
+        start += size;
+    }
+}
+
+uint32_t CanAutobaudTakeResult(CanAutobaud *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    const uint32_t result = self->result;
+    self->result = 0u;
+    return result;
+}
@@ -0,0 +1,43 @@
+/* CAN bit rate detection from RX edge timestamps
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_AUTOBAUD_H_
+#define CORE_SRC_CAN_AUTOBAUD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_edge.h"
+#include "can_glitch.h"
+
+#define CAN_AUTOBAUD_RATES_COUNT (4u)
+
+/* Every level run is matched against the bit times of the standard rates. The shortest bit time
+ * with enough matching runs is the bit rate, longer runs are multiples of it. Pulses shorter than a part of the
+ * fastest bit time are removed first, a rate is taken when two windows in a row agree on it. */
+typedef struct {
+    CanGlitch glitch; /* Fixed to the fastest rate, the filter of the measurement depends on the detected one */
+    uint32_t bit_times[CAN_AUTOBAUD_RATES_COUNT]; /* CPU ticks, ascending */
+    uint32_t counts[CAN_AUTOBAUD_RATES_COUNT];
+    uint32_t runs;
+    uint32_t prev_time;
+    bool prev_time_valid;
+    uint32_t candidate; /* Bit rate of the previous window, 0 = none */
+    uint32_t result;    /* Bit rate, 0 = not detected yet */
+} CanAutobaud;
+
+void CanAutobaudInit(CanAutobaud *self, uint32_t cpu_freq);
+
+/* Forget the previous edge, e.g. after lost edges */
+void CanAutobaudResync(CanAutobaud *self);
+
+/* Batch of edges in time order, before the edge filter. The edges are not changed */
+void CanAutobaudAddEdges(CanAutobaud *self, const CanEdge edges[], size_t count);
+
+/* Returns the bit rate detected since the last call or 0 */
+uint32_t CanAutobaudTakeResult(CanAutobaud *self);
+
+#endif /* CORE_SRC_CAN_AUTOBAUD_H_ */
@@ -0,0 +1,48 @@
+/* CAN RX edge timestamping by timer input capture and circular DMA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_CAPTURE_H_
+#define CORE_SRC_CAN_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+#include "can_edge.h"
+
+/* One capture channel and its DMA buffer */
+typedef struct {
+    uint16_t buffer[CAN_CAPTURE_BUFFER_SIZE]; /* Written by DMA */
+    uint32_t read_position;
+    uint32_t write_position; /* DMA position at the previous read */
+    uint32_t pending_flags;  /* DMA half/full flags expected but not seen yet */
+} CanCaptureChannel;
+
+/* Capture object */
+typedef struct {
+    CanCaptureChannel falling;
+    CanCaptureChannel rising;
+    uint16_t prev_counter; /* Timer counter at the previous read */
+    uint32_t time;         /* prev_counter extended to 32 bit, timer ticks */
+    uint32_t prev_read_cycles;
+    uint32_t overruns; /* Reads that discovered lost edges */
+    bool lost;         /* Edges were lost since the last CanCaptureTakeLost */
+} CanCapture;
+
+/* Start timer and DMA */
+void CanCaptureInit(CanCapture *self);
+
+/* Get new edges of both directions in time order, CPU ticks (DWT->CYCCNT timebase). Returns the count,
+ * 0 when empty. Must be called more often than the timer wraps (65536 * CAN_CAPTURE_PRESCALER CPU ticks),
+ * otherwise the edges can not be placed in time and are dropped. */
+size_t CanCaptureRead(CanCapture *self, CanEdge edges[], size_t max_count);
+
+/* All edges before this time have been read, CPU ticks */
+uint32_t CanCaptureGetTime(const CanCapture *self);
+
+/* Returns true once after edges were lost */
+bool CanCaptureTakeLost(CanCapture *self);
+
+#endif /* CORE_SRC_CAN_CAPTURE_H_ */
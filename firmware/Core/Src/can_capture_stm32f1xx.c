@@ -0,0 +1,216 @@
+/* CAN RX edge timestamping by timer input capture and circular DMA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "can_capture.h"
+#include "delay_cpu_cycles.h"
+
+/* PA15 is TIM2_CH1 with the partial remap 1. IC1 captures falling edges of TI1 and requests DMA1 channel 5,
+ * IC2 captures rising edges of the same TI1 and requests DMA1 channel 7. STM32F1 can't capture both edges
+ * in one channel. The timer clock is 2 * PCLK1 = 64 MHz. */
+
+#define CAN_CAPTURE_TIMER TIM2
+#define CAN_CAPTURE_DMA DMA1
+
+#define CAN_CAPTURE_TIMER_PERIOD (0x10000u)
+#define CAN_CAPTURE_TIMER_PERIOD_MASK (0xFFFF0000u)
+#define CAN_CAPTURE_TIMER_HALF_PERIOD (0x8000u)
+#define CAN_CAPTURE_WRAP_CPU_TICKS (CAN_CAPTURE_TIMER_PERIOD * CAN_CAPTURE_PRESCALER)
+#define CAN_CAPTURE_HOLDBACK (4u) /* Timer ticks. A newer edge may not be transferred by the other DMA yet */
+
+#if (CAN_CAPTURE_BUFFER_SIZE % 2u) != 0u
+#error CAN_CAPTURE_BUFFER_SIZE must be even
+#endif
+
+#if CAN_CAPTURE_PRESCALER < 2u
+#error CanEdge needs the lowest bit of the time
+#endif
+
+typedef struct {
+    DMA_Channel_TypeDef *dma_channel;
+    uint32_t half_flag;
+    uint32_t full_flag;
+} CanCaptureHw;
+
+static const CanCaptureHw can_capture_falling_hw = {DMA1_Channel5, DMA_ISR_HTIF5, DMA_ISR_TCIF5};
+static const CanCaptureHw can_capture_rising_hw = {DMA1_Channel7, DMA_ISR_HTIF7, DMA_ISR_TCIF7};
+
+static void CanCaptureChannelInit(CanCaptureChannel *self, const CanCaptureHw *hw, volatile uint32_t *ccr) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(hw != NULL);
+
+    /* Init variables */
+    (void)memset(self->buffer, 0, sizeof(self->buffer));
+    self->read_position = 0u;
+    self->write_position = 0u;
+    self->pending_flags = 0u;
+
+    /* DMA: CCRx to buffer, 16 bit, circular */
+    hw->dma_channel->CCR = 0u;
+    CAN_CAPTURE_DMA->IFCR = hw->half_flag | hw->full_flag;
+    hw->dma_channel->CPAR = (uint32_t)ccr;
+    hw->dma_channel->CMAR = (uint32_t)self->buffer;
+    hw->dma_channel->CNDTR = CAN_CAPTURE_BUFFER_SIZE;
+    hw->dma_channel->CCR = DMA_CCR_PL_1 | DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_0 | DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_EN;
+}
+
+void CanCaptureInit(CanCapture *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    /* Init variables */
+    self->overruns = 0u;
+    self->lost = false;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* TIM2 partial remap 1. Don't use __HAL_AFIO_REMAP_TIM2_PARTIAL_1, it switches SWD off. */
+    AFIO->MAPR = (AFIO->MAPR & ~(AFIO_MAPR_TIM2_REMAP | AFIO_MAPR_SWJ_CFG)) | AFIO_MAPR_TIM2_REMAP_PARTIALREMAP1 |
+                 AFIO_MAPR_SWJ_CFG_JTAGDISABLE;
+
+    CanCaptureChannelInit(&self->falling, &can_capture_falling_hw, &CAN_CAPTURE_TIMER->CCR1);
+    CanCaptureChannelInit(&self->rising, &can_capture_rising_hw, &CAN_CAPTURE_TIMER->CCR2);
+
+    /* Timer: free running, IC1 = TI1 falling edge, IC2 = TI1 rising edge, DMA request on capture */
+    CAN_CAPTURE_TIMER->CR1 = 0u;
+    CAN_CAPTURE_TIMER->PSC = CAN_CAPTURE_PRESCALER - 1u;
+    CAN_CAPTURE_TIMER->ARR = CAN_CAPTURE_TIMER_PERIOD - 1u;
+    CAN_CAPTURE_TIMER->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_1;
+    CAN_CAPTURE_TIMER->CCER = TIM_CCER_CC1P | TIM_CCER_CC1E | TIM_CCER_CC2E;
+    CAN_CAPTURE_TIMER->DIER = TIM_DIER_CC1DE | TIM_DIER_CC2DE;
+    CAN_CAPTURE_TIMER->EGR = TIM_EGR_UG; /* Load PSC */
+    CAN_CAPTURE_TIMER->SR = 0u;
+
+    /* Align the timebase with DWT->CYCCNT */
+    const uint32_t cycles = GetCpuCycles();
+    CAN_CAPTURE_TIMER->CR1 = TIM_CR1_CEN;
+    self->prev_counter = 0u;
+    self->time = cycles / CAN_CAPTURE_PRESCALER;
+    self->prev_read_cycles = cycles;
+}
+
+/* Is position inside (from, to] of the circular buffer */
+static bool CanCapturePassed(uint32_t position, uint32_t from, uint32_t to) {
+    const uint32_t distance = (position + CAN_CAPTURE_BUFFER_SIZE - from) % CAN_CAPTURE_BUFFER_SIZE;
+    const uint32_t available = (to + CAN_CAPTURE_BUFFER_SIZE - from) % CAN_CAPTURE_BUFFER_SIZE;
+    return (distance != 0u) && (distance <= available);
+}
+
+/* Update write_position, returns true on DMA overrun */
+static bool CanCaptureChannelSync(CanCaptureChannel *self, const CanCaptureHw *hw) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(hw != NULL);
+
+    /* Order matters: a flag raised after it is read is still expected (pending_flags) */
+    const uint32_t flags = CAN_CAPTURE_DMA->ISR & (hw->half_flag | hw->full_flag);
+    const uint32_t write_position = (CAN_CAPTURE_BUFFER_SIZE - hw->dma_channel->CNDTR) % CAN_CAPTURE_BUFFER_SIZE;
+
+    /* Overrun: a half/full flag which can't be explained by the DMA progress */
+    uint32_t expected_flags = self->pending_flags;
+    if (CanCapturePassed(CAN_CAPTURE_BUFFER_SIZE / 2u, self->write_position, write_position)) {
+        expected_flags |= hw->half_flag;
+    }
+    if (CanCapturePassed(0u, self->write_position, write_position)) {
+        expected_flags |= hw->full_flag;
+    }
+    CAN_CAPTURE_DMA->IFCR = flags;
+    self->write_position = write_position;
+    self->pending_flags = expected_flags & ~flags;
+    return (flags & ~expected_flags) != 0u;
+}
+
+static void CanCaptureChannelDrop(CanCaptureChannel *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->read_position = self->write_position;
+    self->pending_flags = 0u;
+}
+
+/* Age of the oldest unread edge in timer ticks, returns false when there is none old enough */
+static inline bool CanCaptureChannelPeek(const CanCaptureChannel *self, uint16_t counter, uint16_t *age) {
+    if (self->read_position == self->write_position) {
+        return false;
+    }
+    *age = counter - self->buffer[self->read_position];
+    return *age >= CAN_CAPTURE_HOLDBACK;
+}
+
+static inline void CanCaptureChannelNext(CanCaptureChannel *self) {
+    self->read_position++;
+    if (self->read_position == CAN_CAPTURE_BUFFER_SIZE) {
+        self->read_position = 0u;
+    }
+}
+
+size_t CanCaptureRead(CanCapture *self, CanEdge edges[], size_t max_count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(edges != NULL);
+
+    /* Order matters: every edge up to write_position was captured before the counter is read */
+    bool overrun = CanCaptureChannelSync(&self->falling, &can_capture_falling_hw);
+    overrun |= CanCaptureChannelSync(&self->rising, &can_capture_rising_hw);
+    const uint16_t counter = (uint16_t)CAN_CAPTURE_TIMER->CNT;
+    const uint32_t cycles = GetCpuCycles();
+
+    /* Extend the counter, DWT resolves the wraps */
+    const uint32_t elapsed_ticks = (cycles - self->prev_read_cycles) / CAN_CAPTURE_PRESCALER;
+    const uint16_t delta = counter - self->prev_counter;
+    self->time += delta + ((elapsed_ticks - delta + CAN_CAPTURE_TIMER_HALF_PERIOD) & CAN_CAPTURE_TIMER_PERIOD_MASK);
+    self->prev_counter = counter;
+    const bool late = (cycles - self->prev_read_cycles) >= CAN_CAPTURE_WRAP_CPU_TICKS;
+    self->prev_read_cycles = cycles;
+
+    const bool unread = (self->falling.read_position != self->falling.write_position) ||
+                        (self->rising.read_position != self->rising.write_position);
+    if (overrun || (late && unread)) {
+        CanCaptureChannelDrop(&self->falling);
+        CanCaptureChannelDrop(&self->rising);
+        self->overruns++;
+        self->lost = true;
+        return 0u;
+    }
+
+    /* Merge both channels, the oldest first */
+    size_t count = 0u;
+    while (count < max_count) {
+        uint16_t falling_age = 0u;
+        uint16_t rising_age = 0u;
+        const bool falling = CanCaptureChannelPeek(&self->falling, counter, &falling_age);
+        const bool rising = CanCaptureChannelPeek(&self->rising, counter, &rising_age);
+        if (falling && ((rising == false) || (falling_age > rising_age))) {
+            edges[count] = CanEdgeMake((self->time - falling_age) * CAN_CAPTURE_PRESCALER, false);
+            CanCaptureChannelNext(&self->falling);
+        } else if (rising) {
+            edges[count] = CanEdgeMake((self->time - rising_age) * CAN_CAPTURE_PRESCALER, true);
+            CanCaptureChannelNext(&self->rising);
+        } else {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+uint32_t CanCaptureGetTime(const CanCapture *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    return (self->time - CAN_CAPTURE_HOLDBACK) * CAN_CAPTURE_PRESCALER;
+}
+
+bool CanCaptureTakeLost(CanCapture *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    const bool lost = self->lost;
+    self->lost = false;
+    return lost;
+}
@@ -0,0 +1,209 @@
+/* CAN bus load indicator compile-time configuration
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_CONFIG_H_
+#define CORE_SRC_CAN_CONFIG_H_
+
+/* Load measurement backend */
+
+#define CAN_LOAD_BACKEND_EDGES (0u) /* Falling edge periods from CAN_EDGE_SOURCE */
+#define CAN_LOAD_BACKEND_GATED (1u) /* TIM2 gated by PA15 integrates the dominant time, EXTI runs for comparison */
+#define CAN_LOAD_BACKEND_FRAMES (2u) /* Sum of frame lengths decoded from the captured edges */
+#define CAN_LOAD_BACKEND_RX (3u) /* Sum of exact lengths of the frames received by bxCAN, no PA15 tap needed */
+
+/* Not FRAMES, the decoder is not measured to keep up with 1 Mbit/s at full load */
+#ifndef CAN_LOAD_BACKEND
+#define CAN_LOAD_BACKEND CAN_LOAD_BACKEND_EDGES
+#endif
+
+/* Edge source */
+
+#define CAN_EDGE_SOURCE_EXTI (0u)    /* Interrupt on every falling edge of PA15 */
+#define CAN_EDGE_SOURCE_CAPTURE (1u) /* TIM2 CH1 input capture of PA15 into a circular DMA buffer */
+
+#ifndef CAN_EDGE_SOURCE
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+#define CAN_EDGE_SOURCE CAN_EDGE_SOURCE_EXTI
+#else
+#define CAN_EDGE_SOURCE CAN_EDGE_SOURCE_CAPTURE
+#endif
+#endif
+
+#if (CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED) && (CAN_EDGE_SOURCE != CAN_EDGE_SOURCE_EXTI)
+#error The gated backend and the input capture both use TIM2
+#endif
+
+#if (CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES) && (CAN_EDGE_SOURCE != CAN_EDGE_SOURCE_CAPTURE)
+#error The frame decoder needs both edges from the input capture
+#endif
+
+/* EXTI storm protection */
+
+#define CAN_GOVERNOR_WINDOW_MS (10u)
+#define CAN_GOVERNOR_MAX_PERCENT (50u)    /* CPU time in the EXTI interrupt that starts sampling */
+#define CAN_GOVERNOR_TARGET_PERCENT (25u) /* CPU time in the EXTI interrupt while sampling */
+#define CAN_GOVERNOR_ISR_OVERHEAD (40u)   /* CPU ticks of the interrupt entry, exit and HAL dispatch */
+
+/* Input capture */
+
+#define CAN_CAPTURE_PRESCALER (8u)       /* CPU ticks per timer tick, the timer wraps every 8.192 ms */
+#define CAN_CAPTURE_BUFFER_SIZE (512u)   /* Edges per direction, must be even. Covers a display update */
+#define CAN_CAPTURE_READ_BATCH (64u)     /* Edges processed per read */
+
+/* Frame decoder */
+
+/* Fastest bit rate decoded at full load, an estimated 60 of 128 CPU ticks per bit at 500 kbit/s.
+ * Above it the frames are not decoded and the FRAMES load falls back to the edges.
+ * Raise it only after C<n> on the gaps page stays below CPU_FREQ / bit rate at full load */
+#ifndef CAN_DECODER_MAX_BITRATE
+#define CAN_DECODER_MAX_BITRATE (500000u)
+#endif
+
+/* Received frames */
+
+#define CAN_FRAME_RING_SIZE (64u)  /* Power of two, 20 bytes per frame. 3 ms of the shortest frames at 1 Mbit/s */
+#define CAN_FRAME_READ_BATCH (8u) /* Frames processed per read */
+
+/* 1 = the FIFO registers are read directly in the interrupt, 0 = through HAL */
+#ifndef CAN_RX_FAST_PATH
+#define CAN_RX_FAST_PATH (1u)
+#endif
+
+/* Per identifier statistics */
+
+#define CAN_ID_TABLE_EVICT_LRU (0u) /* The least recently received identifier is replaced */
+#define CAN_ID_TABLE_EVICT_LFU (1u) /* The least frequently received identifier is replaced */
+
+#define CAN_ID_TABLE_SIZE (64u)      /* Power of two, 40 bytes per identifier */
+#define CAN_ID_TABLE_MAX_PROBES (8u) /* Slots searched for an identifier before an eviction */
+
+#ifndef CAN_ID_TABLE_EVICTION
+#define CAN_ID_TABLE_EVICTION CAN_ID_TABLE_EVICT_LRU
+#endif
+
+#define CAN_TOP_SIZE (4u) /* Identifiers ranked by the share of the bus time, 2 per screen */
+
+/* Schedule of the periodic identifiers */
+
+#define CAN_SCHEDULE_LEARN_PERIODS (8u)      /* Filtered periods averaged into the nominal period */
+#define CAN_SCHEDULE_TOLERANCE_PERCENT (20u) /* Of the period, early or late beyond it */
+#define CAN_SCHEDULE_MISSING_PERCENT (150u)  /* Of the period without a frame, the frame is missing */
+#define CAN_WHEEL_SLOTS (64u)                /* Power of two */
+#define CAN_WHEEL_TICK_SHIFT (16u)           /* 2^16 CPU ticks (1.024 ms) per slot, 65.5 ms per turn */
+
+/* J1939 */
+
+/* 1 = statistics by PGN and source address and transport protocol sessions of the extended frames */
+#ifndef CAN_J1939
+#define CAN_J1939 (0u)
+#endif
+
+#define CAN_J1939_PGN_TABLE_SIZE (32u)    /* Power of two, 12 bytes per PGN */
+#define CAN_J1939_SOURCE_TABLE_SIZE (16u) /* Power of two, 12 bytes per source address */
+#define CAN_J1939_SESSIONS (4u)           /* Concurrent TP.BAM and TP.CMDT transfers, 32 bytes each */
+#define CAN_J1939_TP_TIMEOUT_MS (1250u)   /* T2 of J1939-21, the longest wait for a packet */
+
+/* ISO-TP */
+
+/* 1 = transfers of the diagnostic identifiers: throughput, flow control wait and duration, ECU and tester gaps */
+#ifndef CAN_ISOTP
+#define CAN_ISOTP (1u)
+#endif
+
+#define CAN_ISOTP_SESSIONS (4u)           /* Concurrent request and response pairs, 88 bytes each */
+#define CAN_ISOTP_TIMEOUT_MS (1000u)      /* N_Bs and N_Cr of ISO 15765-2 */
+#define CAN_ISOTP_PAIR_TIMEOUT_MS (5000u) /* P2* of ISO 14229-2, a pair without frames is closed */
+
+/* CANopen */
+
+/* 1 = classes of the standard frames by COB-ID, NMT states and heartbeats of the nodes */
+#ifndef CAN_CANOPEN
+#define CAN_CANOPEN (0u)
+#endif
+
+#define CAN_OPEN_HEARTBEAT_MISSING_PERCENT (150u) /* Of the heartbeat period, the node is lost */
+
+#if (CAN_J1939 != 0u) && (CAN_CANOPEN != 0u)
+#error J1939 and CANopen do not fit in RAM together
+#endif
+
+/* Signals */
+
+#define CAN_SIGNAL_VALUES_SIZE (8u)      /* Signals decoded and shown, 8 bytes of RAM each. Max 32 */
+#define CAN_SIGNALS_FLASH_BUDGET (2048u) /* Max bytes of the tables compiled from the DBC file */
+
+/* Trigger */
+
+/* 1 = the frames around the first trigger event are captured and shown */
+#ifndef CAN_TRIGGER
+#define CAN_TRIGGER (1u)
+#endif
+
+#define CAN_TRIGGER_PRE_FRAMES (8u)     /* Frames kept before the event, 20 bytes each */
+#define CAN_TRIGGER_POST_FRAMES (8u)    /* Frames captured from the event on, 20 bytes each */
+#define CAN_TRIGGER_RULES (2u)          /* Frame rules, all are evaluated for every frame, 24 bytes each */
+#define CAN_TRIGGER_FRAME_UPDATES (10u) /* Display updates per captured frame */
+
+/* Armed at start. The frame rule is the key (identifier, bit 31 for the extended frames) and the payload
+ * (byte 0 is the low byte, the bytes after the DLC are zero) under the masks */
+#define CAN_TRIGGER_KEY (0x000u)
+#define CAN_TRIGGER_KEY_MASK (0x00000000u) /* 0 with the data mask 0 = no frame rule */
+#define CAN_TRIGGER_DATA (0x0000000000000000ull)
+#define CAN_TRIGGER_DATA_MASK (0x0000000000000000ull)
+#define CAN_TRIGGER_ON_ERROR (1u)      /* Bus errors and error frames */
+#define CAN_TRIGGER_LOAD_PERCENT (90u) /* 0 = off */
+
+/* Focused analysis */
+
+/* 1 = the bxCAN filters pass CAN_FILTER_WANTED and a few false positives, 0 = every frame */
+#ifndef CAN_FILTER_FOCUS
+#define CAN_FILTER_FOCUS (0u)
+#endif
+
+/* Identifier ranges: first, last, extended */
+#define CAN_FILTER_WANTED {{0x100u, 0x1FFu, false}, {0x7DFu, 0x7EFu, false}, {0x18DAF100u, 0x18DAF1FFu, true}}
+#define CAN_FILTER_MAX_BLOCKS (56u) /* Aligned blocks during the synthesis, 8 bytes of stack each. 14 banks of 4 */
+
+#if (CAN_FILTER_FOCUS != 0u) && (CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_RX)
+#error The RX load needs every frame, the focus filters drop most of them
+#endif
+
+/* Bus */
+
+#define CAN_BITRATE (500000u) /* Initial bit rate */
+
+/* Bit rate detection from the captured edges, CAN bit timing is reprogrammed at runtime */
+#ifndef CAN_AUTOBAUD
+#if (CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_CAPTURE) && (CAN_LOAD_BACKEND != CAN_LOAD_BACKEND_RX)
+#define CAN_AUTOBAUD (1u)
+#else
+#define CAN_AUTOBAUD (0u)
+#endif
+#endif
+
+#if (CAN_AUTOBAUD != 0u) && (CAN_EDGE_SOURCE != CAN_EDGE_SOURCE_CAPTURE)
+#error The bit rate detection needs the input capture
+#endif
+
+/* Edge filter */
+
+#define CAN_GLITCH_MIN_WIDTH_PERCENT (25u) /* Shorter pulses are EMI spikes. Percent of the bit time, 0 = off */
+
+/* Load measurement */
+
+#define CAN_PAYLOAD_BITS (11u) /* Active time counted after a falling edge */
+
+/* Display */
+
+#define CAN_DISPLAY_PAGE_UPDATES (50u) /* Display updates (100 ms) before the next page */
+
+/* Load history, fixed size: a byte per sample and 2 bytes per bucket, 5.8 KB */
+
+#define CAN_HISTORY_SAMPLES_PER_SECOND (10u) /* Display update rate */
+#define CAN_HISTORY_SAMPLES_SIZE (600u)      /* 100 ms for a minute */
+#define CAN_HISTORY_SECONDS_SIZE (1200u)     /* 1 s for 20 minutes */
+#define CAN_HISTORY_MINUTES_SIZE (1440u)     /* 1 min for 24 hours */
+
+#endif /* CORE_SRC_CAN_CONFIG_H_ */
@@ -0,0 +1,424 @@
+/* CAN frame reconstruction from RX edge timestamps
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_decoder.h"
+#include <assert.h>
+#include <string.h>
+
+/* Frame format */
+
+#define CAN_DOMINANT (0u)
+#define CAN_RECESSIVE (1u)
+#define CAN_IDLE_BITS (11u)          /* ACK delimiter + EOF + intermission */
+#define CAN_STUFF_BITS (5u)          /* A stuff bit follows 5 equal bits */
+#define CAN_ID_A_BITS (11u)
+#define CAN_ID_B_BITS (18u)
+#define CAN_DLC_BITS (4u)
+#define CAN_DLC_MASK (0x0Fu)
+#define CAN_ID_A_FIELD_BITS (CAN_ID_A_BITS + 2u)               /* SRR or RTR, IDE */
+#define CAN_ID_B_FIELD_BITS (CAN_ID_B_BITS + 3u + CAN_DLC_BITS) /* RTR, r1, r0 */
+#define CAN_DLC_FIELD_BITS (1u + CAN_DLC_BITS)                  /* r0 */
+#define CAN_CRC_BITS (15u)
+#define CAN_EOF_BITS (7u)
+#define CAN_INTERMISSION_BITS (3u)
+#define CAN_ERROR_FLAG_BITS (6u) /* Breaks the stuffing rule */
+#define CAN_ERROR_DELIMITER_BITS (8u)
+#define CAN_MAX_DATA_BYTES (8u)
+#define CAN_BITS_IN_BYTE (8u)
+#define CAN_CRC_MASK (0x7FFFu)
+
+/* CRC-15 of up to CAN_STUFF_BITS bits shifted out of the top of the register, by the bits shifted out xor the
+ * input bits. A shorter shift uses the head of the table, the first 16 are the nibble table of can_frame_length.c */
+static const uint16_t can_decoder_crc_table[1u << CAN_STUFF_BITS] = {
+    0x0000u, 0x4599u, 0x4EABu, 0x0B32u, 0x58CFu, 0x1D56u, 0x1664u, 0x53FDu,
+    0x7407u, 0x319Eu, 0x3AACu, 0x7F35u, 0x2CC8u, 0x6951u, 0x6263u, 0x27FAu,
+    0x2D97u, 0x680Eu, 0x633Cu, 0x26A5u, 0x7558u, 0x30C1u, 0x3BF3u, 0x7E6Au,
+    0x5990u, 0x1C09u, 0x173Bu, 0x52A2u, 0x015Fu, 0x44C6u, 0x4FF4u, 0x0A6Du,
+};
+
+void CanDecoderInit(CanDecoder *self, uint32_t bit_time, CanDecoderFrameCallback callback, void *callback_context) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(bit_time > 0u);
+
+    (void)memset(self, 0, sizeof(*self));
+    self->bit_time = bit_time;
+    self->callback = callback;
+    self->callback_context = callback_context;
+    CanDecoderResync(self);
+}
+
+void CanDecoderResync(CanDecoder *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->run_valid = false;
+    self->state = CAN_DECODER_WAIT_IDLE;
+    self->idle_bits = 0u;
+}
+
+void CanDecoderSetBitTime(CanDecoder *self, uint32_t bit_time) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(bit_time > 0u);
+
+    self->bit_time = bit_time;
+    CanDecoderResync(self);
+}
+
+static inline void CanDecoderStartField(CanDecoder *self, CanDecoderState state, uint32_t bits) {
+    self->state = state;
+    self->field_bits = bits;
+    self->field_value = 0u;
+}
+
+static void CanDecoderError(CanDecoder *self, uint32_t *counter) {
+    (*counter)++;
+    self->state = CAN_DECODER_WAIT_IDLE;
+    self->idle_bits = 0u;
+}
+
+static void CanDecoderStartOfFrame(CanDecoder *self, uint32_t time) {
+    self->frame.start_time = time;
+    self->frame.id = 0u;
+    self->frame.length = 1u;
+    self->frame.dlc = 0u;
+    self->frame.flags = 0u;
+    self->stuffing = true;
+    self->last_bit = CAN_DOMINANT;
+    self->same_bits = 1u;
+    self->crc = 0u; /* CRC of the dominant SOF is 0 */
+    CanDecoderStartField(self, CAN_DECODER_ID_A, CAN_ID_A_FIELD_BITS);
+}
+
+static void CanDecoderEndOfFrame(CanDecoder *self, uint32_t end_time) {
+    self->frame.length += CAN_INTERMISSION_BITS;
+    self->frame.end_time = end_time + (CAN_INTERMISSION_BITS * self->bit_time);
+    self->frames++;
+    self->busy_time += self->frame.end_time - self->frame.start_time;
+    if (self->callback != NULL) {
+        self->callback(self->callback_context, &self->frame);
+    }
+}
+
+/* Data or CRC follows */
+static void CanDecoderDlc(CanDecoder *self, uint32_t dlc) {
+    self->frame.dlc = (uint8_t)dlc;
+    const uint32_t bytes = (dlc < CAN_MAX_DATA_BYTES) ? dlc : CAN_MAX_DATA_BYTES;
+    if (((self->frame.flags & CAN_DECODED_FRAME_RTR) != 0u) || (bytes == 0u)) {
+        self->crc_calculated = self->crc;
+        CanDecoderStartField(self, CAN_DECODER_CRC, CAN_CRC_BITS);
+    } else {
+        CanDecoderStartField(self, CAN_DECODER_DATA, bytes * CAN_BITS_IN_BYTE);
+    }
+}
+
+/* The whole field is received. The fields before CRC are few and long, a run mostly ends inside one */
+static void CanDecoderField(CanDecoder *self, uint32_t bit, uint32_t time) {
+    const uint32_t value = self->field_value;
+    switch (self->state) {
+        case CAN_DECODER_ID_A:
+            self->frame.id = value >> 2u;
+            if ((value & 2u) != 0u) {
+                self->frame.flags |= CAN_DECODED_FRAME_RTR;
+            }
+            if ((value & 1u) != 0u) {
+                self->frame.flags |= CAN_DECODED_FRAME_EXTENDED;
+                CanDecoderStartField(self, CAN_DECODER_ID_B, CAN_ID_B_FIELD_BITS);
+            } else {
+                CanDecoderStartField(self, CAN_DECODER_DLC, CAN_DLC_FIELD_BITS);
+            }
+            break;
+        case CAN_DECODER_ID_B:
+            self->frame.id = (self->frame.id << CAN_ID_B_BITS) | (value >> (3u + CAN_DLC_BITS));
+            /* The SRR bit of an extended frame is not RTR */
+            self->frame.flags &= ~CAN_DECODED_FRAME_RTR;
+            if ((value & (4u << CAN_DLC_BITS)) != 0u) {
+                self->frame.flags |= CAN_DECODED_FRAME_RTR;
+            }
+            CanDecoderDlc(self, value & CAN_DLC_MASK);
+            break;
+        case CAN_DECODER_DLC:
+            CanDecoderDlc(self, value & CAN_DLC_MASK);
+            break;
+        case CAN_DECODER_DATA:
+            self->crc_calculated = self->crc;
+            CanDecoderStartField(self, CAN_DECODER_CRC, CAN_CRC_BITS);
+            break;
+        case CAN_DECODER_CRC:
+            if (self->crc_calculated != (uint16_t)value) {
+                self->frame.flags |= CAN_DECODED_FRAME_CRC_ERROR;
+                self->crc_errors++;
+            }
+            self->state = CAN_DECODER_CRC_DELIMITER; /* field_bits stays 1, every next bit is a field */
+            break;
+        case CAN_DECODER_CRC_DELIMITER:
+            if (bit != CAN_RECESSIVE) {
+                CanDecoderError(self, &self->form_errors);
+            } else {
+                self->state = CAN_DECODER_ACK_SLOT;
+            }
+            break;
+        case CAN_DECODER_ACK_SLOT:
+            if (bit != CAN_DOMINANT) {
+                self->frame.flags |= CAN_DECODED_FRAME_NO_ACK;
+            }
+            self->state = CAN_DECODER_ACK_DELIMITER;
+            break;
+        case CAN_DECODER_ACK_DELIMITER:
+            if (bit != CAN_RECESSIVE) {
+                CanDecoderError(self, &self->form_errors);
+            } else {
+                self->state = CAN_DECODER_EOF;
+                self->idle_bits = 0u; /* Counts EOF bits */
+            }
+            break;
+        case CAN_DECODER_EOF:
+            if (bit != CAN_RECESSIVE) {
+                CanDecoderError(self, &self->form_errors);
+            } else {
+                self->idle_bits++;
+                if (self->idle_bits == CAN_EOF_BITS) {
+                    CanDecoderEndOfFrame(self, time + self->bit_time);
+                    self->state = CAN_DECODER_INTERMISSION;
+                    self->idle_bits = 0u;
+                }
+            }
+            break;
+        case CAN_DECODER_INTERMISSION:
+            if (bit != CAN_RECESSIVE) {
+                if (self->idle_bits == (CAN_INTERMISSION_BITS - 1u)) {
+                    /* SOF is allowed in the third bit of intermission */
+                    CanDecoderStartOfFrame(self, time);
+                } else {
+                    /* Overload frame */
+                    self->state = CAN_DECODER_WAIT_IDLE;
+                    self->idle_bits = 0u;
+                }
+            } else {
+                self->idle_bits++;
+                if (self->idle_bits == CAN_INTERMISSION_BITS) {
+                    self->state = CAN_DECODER_IDLE;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* Equal bits of a run inside the stuffed part of a frame, up to the end of the field or the next stuff bit.
+ * The stuffing, the CRC and the field take them at once. Returns the bits taken, 0 at the end of stuffing */
+static inline uint32_t CanDecoderStuffedBits(CanDecoder *self, uint32_t bit, uint32_t bits, uint32_t time) {
+    const uint32_t same_bits = (bit == self->last_bit) ? self->same_bits : 0u;
+    if (same_bits == CAN_STUFF_BITS) {
+        /* Equal to the 5 before, a stuff bit was expected */
+        CanDecoderError(self, &self->stuff_errors);
+        return 1u;
+    }
+    if (self->same_bits == CAN_STUFF_BITS) {
+        /* Stuff bit, it starts a run of the opposite level */
+        self->last_bit = (uint8_t)bit;
+        self->same_bits = 1u;
+        self->frame.length++;
+        return 1u;
+    }
+    if (self->state == CAN_DECODER_CRC_DELIMITER) {
+        /* There was no stuff bit after CRC */
+        self->stuffing = false;
+        return 0u;
+    }
+    uint32_t count = CAN_STUFF_BITS - same_bits;
+    if (count > bits) {
+        count = bits;
+    }
+    if (count > self->field_bits) {
+        count = self->field_bits;
+    }
+    const uint32_t value = (bit != CAN_DOMINANT) ? ((1u << count) - 1u) : 0u;
+    self->last_bit = (uint8_t)bit;
+    self->same_bits = (uint8_t)(same_bits + count);
+    if (self->state < CAN_DECODER_CRC) {
+        const uint32_t crc = self->crc;
+        self->crc = (uint16_t)(((crc << count) & CAN_CRC_MASK) ^
+                               can_decoder_crc_table[(crc >> (CAN_CRC_BITS - count)) ^ value]);
+    }
+    self->frame.length += (uint16_t)count;
+    self->field_value = (self->field_value << count) | value;
+    self->field_bits -= count;
+    if (self->field_bits == 0u) {
+        self->field_bits = 1u; /* As a single bit field, the states after CRC take a bit each */
+        CanDecoderField(self, bit, time + ((count - 1u) * self->bit_time));
+    }
+    return count;
+}
+
+/* A whole run inside the stuffed fields up to CRC, the common case: at most 5 bits, a stuff bit first after 5 equal
+ * bits, the field goes on after the run. The CRC of the CRC field itself is not used. A run partly decoded by
+ * CanDecoderFlush has the level of the last bit and is left to CanDecoderRun. Returns false for CanDecoderRun */
+static inline bool CanDecoderStuffedRun(CanDecoder *self, uint32_t bit, uint32_t bits) {
+    const uint32_t stuff_bit = (self->same_bits == CAN_STUFF_BITS) ? 1u : 0u;
+    const uint32_t data_bits = bits - stuff_bit;
+    if ((((uint32_t)self->state - CAN_DECODER_ID_A) > (CAN_DECODER_CRC - CAN_DECODER_ID_A)) ||
+        (bits > CAN_STUFF_BITS) || (data_bits >= self->field_bits) || (bit == self->last_bit)) {
+        return false;
+    }
+    const uint32_t value = (bit != CAN_DOMINANT) ? ((1u << data_bits) - 1u) : 0u;
+    const uint32_t crc = self->crc;
+    self->crc = (uint16_t)(((crc << data_bits) & CAN_CRC_MASK) ^
+                           can_decoder_crc_table[(crc >> (CAN_CRC_BITS - data_bits)) ^ value]);
+    self->field_value = (self->field_value << data_bits) | value;
+    self->field_bits -= data_bits;
+    self->frame.length += (uint16_t)bits;
+    self->last_bit = (uint8_t)bit;
+    self->same_bits = (uint8_t)bits;
+    return true;
+}
+
+/* Recessive bits of EOF and intermission at once. Returns the bits taken */
+static uint32_t CanDecoderRecessiveBits(CanDecoder *self, uint32_t bits, uint32_t time) {
+    const uint32_t field_bits = (self->state == CAN_DECODER_EOF) ? CAN_EOF_BITS : CAN_INTERMISSION_BITS;
+    uint32_t count = field_bits - self->idle_bits;
+    if (count > bits) {
+        count = bits;
+    }
+    self->idle_bits += count;
+    if (self->state == CAN_DECODER_EOF) {
+        self->frame.length += (uint16_t)count;
+        if (self->idle_bits == CAN_EOF_BITS) {
+            CanDecoderEndOfFrame(self, time + (count * self->bit_time));
+            self->state = CAN_DECODER_INTERMISSION;
+            self->idle_bits = 0u;
+        }
+    } else if (self->idle_bits == CAN_INTERMISSION_BITS) {
+        self->state = CAN_DECODER_IDLE;
+    }
+    return count;
+}
+
+/* One bit after the stuffed part of a frame */
+static inline void CanDecoderBit(CanDecoder *self, uint32_t bit, uint32_t time) {
+    self->frame.length++;
+    self->field_value = (self->field_value << 1u) | bit;
+    if (self->field_bits > 1u) {
+        self->field_bits--;
+    } else {
+        CanDecoderField(self, bit, time);
+    }
+}
+
+/* A run of equal bits, inside a frame a field or a stuff bit at a time */
+static void CanDecoderRun(CanDecoder *self, uint32_t bit, uint32_t bits, uint32_t time) {
+    uint32_t remain = bits;
+    uint32_t bit_start = time;
+    while (remain > 0u) {
+        const CanDecoderState state = self->state;
+        uint32_t count = 1u;
+        if (state == CAN_DECODER_WAIT_IDLE) {
+            if (bit == CAN_DOMINANT) {
+                self->idle_bits = 0u;
+            } else {
+                self->idle_bits += remain;
+                if (self->idle_bits >= CAN_IDLE_BITS) {
+                    self->state = CAN_DECODER_IDLE;
+                }
+            }
+            return;
+        }
+        if (state == CAN_DECODER_IDLE) {
+            if (bit != CAN_DOMINANT) {
+                return;
+            }
+            CanDecoderStartOfFrame(self, bit_start);
+        } else if (self->stuffing) {
+            count = CanDecoderStuffedBits(self, bit, remain, bit_start);
+        } else if ((bit != CAN_DOMINANT) && ((state == CAN_DECODER_EOF) || (state == CAN_DECODER_INTERMISSION))) {
+            count = CanDecoderRecessiveBits(self, remain, bit_start);
+        } else {
+            CanDecoderBit(self, bit, bit_start);
+        }
+        remain -= count;
+        bit_start += count * self->bit_time;
+    }
+}
+
+/* An active error flag, possibly superimposed by the flags of other nodes. The aborted frame is error time too */
+static void CanDecoderErrorFrame(CanDecoder *self, uint32_t start_time, uint32_t flag_bits) {
+    const uint32_t end_time =
+        self->run_start + ((flag_bits + CAN_ERROR_DELIMITER_BITS + CAN_INTERMISSION_BITS) * self->bit_time);
+    self->error_frames++;
+    self->error_time += end_time - start_time;
+}
+
+/* Process the current run up to the given bit count */
+static void CanDecoderRunTo(CanDecoder *self, uint32_t bits) {
+    if (bits > self->run_bits_done) {
+        CanDecoderRun(self, self->run_level, bits - self->run_bits_done,
+                      self->run_start + (self->run_bits_done * self->bit_time));
+        self->run_bits_done = bits;
+    }
+}
+
+void CanDecoderAddEdges(CanDecoder *self, const CanEdge edges[], size_t count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((edges != NULL) || (count == 0u));
+
+    /* The run is kept in locals while the fast path takes the edges */
+    const uint32_t bit_time = self->bit_time;
+    uint32_t run_level = self->run_level;
+    uint32_t run_start = self->run_start;
+    size_t i = 0u;
+    if ((count != 0u) && !self->run_valid) {
+        run_level = CanEdgeIsRising(edges[0]) ? CAN_RECESSIVE : CAN_DOMINANT;
+        run_start = CanEdgeTime(edges[0]);
+        self->run_valid = true;
+        self->run_bits_done = 0u;
+        i = 1u;
+    }
+    for (; i < count; i++) {
+        const uint32_t level = CanEdgeIsRising(edges[i]) ? CAN_RECESSIVE : CAN_DOMINANT;
+        const uint32_t time = CanEdgeTime(edges[i]);
+        if (level != run_level) {
+            uint32_t bits = ((time - run_start) + (bit_time / 2u)) / bit_time;
+            if (bits == 0u) {
+                bits = 1u;
+            }
+            if (!CanDecoderStuffedRun(self, run_level, bits)) {
+                self->run_level = (uint8_t)run_level;
+                self->run_start = run_start;
+                const CanDecoderState run_state = self->state;
+                const uint32_t frame_start_time = self->frame.start_time;
+                CanDecoderRunTo(self, bits);
+                /* An overload flag in the intermission is not an error */
+                if ((run_level == CAN_DOMINANT) && (bits >= CAN_ERROR_FLAG_BITS) &&
+                    (run_state != CAN_DECODER_INTERMISSION)) {
+                    const bool in_frame = (run_state >= CAN_DECODER_ID_A) && (run_state <= CAN_DECODER_EOF);
+                    CanDecoderErrorFrame(self, in_frame ? frame_start_time : run_start, bits);
+                }
+                self->run_bits_done = 0u;
+            }
+        } else {
+            /* An edge was lost */
+            CanDecoderResync(self);
+            self->run_valid = true;
+            self->run_bits_done = 0u;
+        }
+        run_level = level;
+        run_start = time;
+    }
+    self->run_level = (uint8_t)run_level;
+    self->run_start = run_start;
+}
+
+void CanDecoderFlush(CanDecoder *self, uint32_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    if (self->run_valid && (self->run_level == CAN_RECESSIVE) && ((int32_t)(now - self->run_start) > 0)) {
+        CanDecoderRunTo(self, (now - self->run_start) / self->bit_time);
+    }
+}
@@ -0,0 +1,98 @@
+/* CAN frame reconstruction from RX edge timestamps
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_DECODER_H_
+#define CORE_SRC_CAN_DECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_edge.h"
+
+/* Decoded frame flags */
+#define CAN_DECODED_FRAME_EXTENDED (0x01u)
+#define CAN_DECODED_FRAME_RTR (0x02u)
+#define CAN_DECODED_FRAME_CRC_ERROR (0x04u)
+#define CAN_DECODED_FRAME_NO_ACK (0x08u)
+
+/* Decoded frame */
+typedef struct {
+    uint32_t start_time; /* Falling edge of SOF, CPU ticks */
+    uint32_t end_time;   /* End of intermission, CPU ticks */
+    uint32_t id;
+    uint16_t length; /* Bits from SOF to the end of intermission, including stuff bits */
+    uint8_t dlc;
+    uint8_t flags;
+} CanDecodedFrame;
+
+typedef void (*CanDecoderFrameCallback)(void *context, const CanDecodedFrame *frame);
+
+typedef enum {
+    CAN_DECODER_WAIT_IDLE, /* 11 recessive bits are needed to find SOF */
+    CAN_DECODER_IDLE,
+    CAN_DECODER_ID_A, /* Identifier, SRR or RTR, IDE */
+    CAN_DECODER_ID_B, /* Extended identifier, RTR, r1, r0, DLC */
+    CAN_DECODER_DLC,  /* r0, DLC */
+    CAN_DECODER_DATA,
+    CAN_DECODER_CRC,
+    CAN_DECODER_CRC_DELIMITER,
+    CAN_DECODER_ACK_SLOT,
+    CAN_DECODER_ACK_DELIMITER,
+    CAN_DECODER_EOF,
+    CAN_DECODER_INTERMISSION
+} CanDecoderState;
+
+/* Decoder object */
+typedef struct {
+    /* Settings */
+    uint32_t bit_time; /* CPU ticks */
+    CanDecoderFrameCallback callback;
+    void *callback_context;
+
+    /* Current run of equal levels */
+    bool run_valid;
+    uint8_t run_level; /* 0 = dominant, 1 = recessive */
+    uint32_t run_start;
+    uint32_t run_bits_done;
+
+    /* Bit stream */
+    CanDecoderState state;
+    uint32_t idle_bits;
+    uint32_t field_bits;
+    uint32_t field_value;
+    bool stuffing;
+    uint8_t last_bit;
+    uint8_t same_bits;
+    uint16_t crc;
+    uint16_t crc_calculated;
+    CanDecodedFrame frame;
+
+    /* Statistics */
+    uint32_t frames;
+    uint32_t busy_time; /* Sum of decoded frame lengths, CPU ticks */
+    uint32_t stuff_errors;
+    uint32_t form_errors;
+    uint32_t crc_errors;
+    uint32_t error_frames; /* Dominant runs of 6 or more bits */
+    uint32_t error_time;   /* Aborted frames and error frames up to the end of intermission, CPU ticks */
+} CanDecoder;
+
+/* The callback is optional and is called for every decoded frame */
+void CanDecoderInit(CanDecoder *self, uint32_t bit_time, CanDecoderFrameCallback callback, void *callback_context);
+
+/* Forget the bit stream, e.g. after lost edges */
+void CanDecoderResync(CanDecoder *self);
+
+/* Change the bit rate at runtime, the bit stream is forgotten */
+void CanDecoderSetBitTime(CanDecoder *self, uint32_t bit_time);
+
+/* Batch of edges in time order */
+void CanDecoderAddEdges(CanDecoder *self, const CanEdge edges[], size_t count);
+
+/* Decode the current recessive level up to now, so a frame is reported without waiting for the next edge */
+void CanDecoderFlush(CanDecoder *self, uint32_t now);
+
+#endif /* CORE_SRC_CAN_DECODER_H_ */
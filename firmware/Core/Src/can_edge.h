@@ -0,0 +1,31 @@
+/* CAN RX edge timestamp
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_EDGE_H_
+#define CORE_SRC_CAN_EDGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Time of the edge in CPU ticks. The captured times are multiples of CAN_CAPTURE_PRESCALER,
+ * so the lowest bit is free and holds the direction. */
+typedef uint32_t CanEdge;
+
+#define CAN_EDGE_RISING (1u) /* Dominant to recessive */
+
+static inline CanEdge CanEdgeMake(uint32_t time, bool rising) {
+    return (time & ~CAN_EDGE_RISING) | (rising ? CAN_EDGE_RISING : 0u);
+}
+
+static inline uint32_t CanEdgeTime(CanEdge edge) {
+    return edge & ~CAN_EDGE_RISING;
+}
+
+static inline bool CanEdgeIsRising(CanEdge edge) {
+    return (edge & CAN_EDGE_RISING) != 0u;
+}
+
+#endif /* CORE_SRC_CAN_EDGE_H_ */
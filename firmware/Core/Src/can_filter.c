@@ -0,0 +1,252 @@
+/* bxCAN filter banks synthesized for a set of wanted identifiers
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_filter.h"
+#include <assert.h>
+
+#define CAN_FILTER_STID_BITS (11u)
+#define CAN_FILTER_EXID_BITS (29u)
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+/* value with the low free_bits cleared, 2^free_bits identifiers */
+typedef struct {
+    uint32_t value;
+    uint8_t free_bits;
+    bool extended;
+} CanFilterBlock;
+
+static uint32_t CanFilterGetMask(uint32_t free_bits, uint32_t id_bits) {
+    return ((1u << id_bits) - 1u) & ~((1u << free_bits) - 1u);
+}
+
+static bool CanFilterContains(const CanFilterBlock *outer, const CanFilterBlock *inner) {
+    return (outer->extended == inner->extended) && (outer->free_bits >= inner->free_bits) &&
+           (((outer->value ^ inner->value) >> outer->free_bits) == 0u);
+}
+
+/* The smallest block with both */
+static CanFilterBlock CanFilterMerge(const CanFilterBlock *a, const CanFilterBlock *b) {
+    uint32_t free_bits = (a->free_bits > b->free_bits) ? a->free_bits : b->free_bits;
+    while (((a->value ^ b->value) >> free_bits) != 0u) {
+        free_bits++;
+    }
+    CanFilterBlock merged;
+    merged.value = a->value & ~((1u << free_bits) - 1u);
+    merged.free_bits = (uint8_t)free_bits;
+    merged.extended = a->extended;
+    return merged;
+}
+
+/* Blocks never overlap, a block inside the new one is removed */
+static void CanFilterInsert(CanFilterBlock blocks[], uint32_t *count, const CanFilterBlock *block) {
+    uint32_t kept = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < *count; i++) {
+        if (CanFilterContains(&blocks[i], block)) {
+            return;
+        }
+        if (!CanFilterContains(block, &blocks[i])) {
+            blocks[kept] = blocks[i];
+            kept++;
+        }
+    }
+    blocks[kept] = *block;
+    *count = kept + 1u;
+}
+
+/* O(count^3), count is at most CAN_FILTER_MAX_BLOCKS */
+static void CanFilterMergeCheapest(CanFilterBlock blocks[], uint32_t *count) {
+    uint32_t best_cost = UINT32_MAX;
+    CanFilterBlock best = {0};
+    uint32_t a = 0u;
+    for (a = 0u; a < *count; a++) {
+        uint32_t b = 0u;
+        for (b = a + 1u; b < *count; b++) {
+            if (blocks[a].extended != blocks[b].extended) {
+                continue;
+            }
+            const CanFilterBlock merged = CanFilterMerge(&blocks[a], &blocks[b]);
+            uint32_t cost = 1u << merged.free_bits;
+            uint32_t i = 0u;
+            for (i = 0u; i < *count; i++) {
+                if (CanFilterContains(&merged, &blocks[i])) {
+                    cost -= 1u << blocks[i].free_bits;
+                }
+            }
+            if (cost < best_cost) {
+                best_cost = cost;
+                best = merged;
+            }
+        }
+    }
+    assert(best_cost != UINT32_MAX);
+    CanFilterInsert(blocks, count, &best);
+}
+
+/* Index of can_filter_kinds */
+static uint32_t CanFilterGetKind(const CanFilterBlock *block) {
+    return (block->extended ? 2u : 0u) + ((block->free_bits != 0u) ? 1u : 0u);
+}
+
+/* Standard identifiers in 16-bit lists, standard blocks in 16-bit masks,
+ * extended identifiers in 32-bit lists, extended blocks in 32-bit masks */
+static const struct {
+    CanFilterMode mode;
+    uint32_t slots;
+} can_filter_kinds[4] = {
+    {CAN_FILTER_LIST_16, 4u},
+    {CAN_FILTER_MASK_16, 2u},
+    {CAN_FILTER_LIST_32, 2u},
+    {CAN_FILTER_MASK_32, 1u},
+};
+
+/* A 16-bit half of FR1 or FR2 in the 16-bit lists, FR1 or FR2 in the 16-bit masks and the 32-bit lists */
+static void CanFilterSetSlot(CanFilterBank *bank, uint32_t slot, const CanFilterBlock *block) {
+    const uint32_t stid = block->value * CAN_FILTER16_STID_LSB;
+    const uint32_t exid = (block->value * CAN_FILTER_EXID_LSB) | CAN_FILTER_IDE;
+    uint32_t *fr = (slot < 2u) ? &bank->fr1 : &bank->fr2;
+    switch (bank->mode) {
+        case CAN_FILTER_LIST_16:
+            *fr |= stid << ((slot % 2u) * 16u);
+            break;
+        case CAN_FILTER_MASK_16:
+            fr = (slot == 0u) ? &bank->fr1 : &bank->fr2;
+            *fr = (((CanFilterGetMask(block->free_bits, CAN_FILTER_STID_BITS) * CAN_FILTER16_STID_LSB) |
+                    CAN_FILTER16_IDE)
+                   << 16u) |
+                  stid;
+            break;
+        case CAN_FILTER_LIST_32:
+            fr = (slot == 0u) ? &bank->fr1 : &bank->fr2;
+            *fr = exid;
+            break;
+        default:
+            bank->fr1 = exid;
+            bank->fr2 = (CanFilterGetMask(block->free_bits, CAN_FILTER_EXID_BITS) * CAN_FILTER_EXID_LSB) |
+                        CAN_FILTER_IDE;
+            break;
+    }
+}
+
+static uint32_t CanFilterGetBanks(const CanFilterBlock blocks[], uint32_t count) {
+    uint32_t counts[ARRAY_SIZE(can_filter_kinds)] = {0u};
+    uint32_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        counts[CanFilterGetKind(&blocks[i])]++;
+    }
+    uint32_t banks = 0u;
+    for (i = 0u; i < ARRAY_SIZE(can_filter_kinds); i++) {
+        banks += (counts[i] + can_filter_kinds[i].slots - 1u) / can_filter_kinds[i].slots;
+    }
+    return banks;
+}
+
+/* The blocks of one kind, the free slots of the last bank repeat its first block */
+static void CanFilterEmit(CanFilterSet *self, const CanFilterBlock blocks[], uint32_t count, uint32_t kind) {
+    const uint32_t slots = can_filter_kinds[kind].slots;
+    CanFilterBank *bank = NULL;
+    const CanFilterBlock *first = NULL;
+    uint32_t slot = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        if (CanFilterGetKind(&blocks[i]) != kind) {
+            continue;
+        }
+        if (slot == 0u) {
+            assert(self->banks_count < CAN_FILTER_BANKS_COUNT);
+            bank = &self->banks[self->banks_count];
+            self->banks_count++;
+            bank->fr1 = 0u;
+            bank->fr2 = 0u;
+            bank->mode = can_filter_kinds[kind].mode;
+            first = &blocks[i];
+        }
+        CanFilterSetSlot(bank, slot, &blocks[i]);
+        slot = (slot + 1u) % slots;
+    }
+    while (slot != 0u) {
+        CanFilterSetSlot(bank, slot, first);
+        slot = (slot + 1u) % slots;
+    }
+}
+
+void CanFilterSynthesize(CanFilterSet *self, const CanFilterRange ranges[], size_t count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(ranges != NULL);
+
+    CanFilterBlock blocks[CAN_FILTER_MAX_BLOCKS];
+    uint32_t blocks_count = 0u;
+    self->wanted_ids = 0u;
+    size_t r = 0u;
+    for (r = 0u; r < count; r++) {
+        self->wanted_ids += (ranges[r].last - ranges[r].first) + 1u;
+        const uint32_t id_bits = ranges[r].extended ? CAN_FILTER_EXID_BITS : CAN_FILTER_STID_BITS;
+        assert(ranges[r].first <= ranges[r].last);
+        assert(ranges[r].last < (1u << id_bits));
+        (void)id_bits;
+
+        /* The largest aligned block from first that ends within the range */
+        uint32_t first = ranges[r].first;
+        bool done = false;
+        while (!done) {
+            uint32_t free_bits = 0u;
+            while (((first & ((2u << free_bits) - 1u)) == 0u) && ((first + (2u << free_bits) - 1u) <= ranges[r].last)) {
+                free_bits++;
+            }
+            CanFilterBlock block;
+            block.value = first;
+            block.free_bits = (uint8_t)free_bits;
+            block.extended = ranges[r].extended;
+            if (blocks_count == CAN_FILTER_MAX_BLOCKS) {
+                CanFilterMergeCheapest(blocks, &blocks_count);
+            }
+            CanFilterInsert(blocks, &blocks_count, &block);
+            const uint32_t last = first + ((1u << free_bits) - 1u);
+            done = last >= ranges[r].last;
+            first = last + 1u;
+        }
+    }
+
+    while (CanFilterGetBanks(blocks, blocks_count) > CAN_FILTER_BANKS_COUNT) {
+        CanFilterMergeCheapest(blocks, &blocks_count);
+    }
+
+    self->passed_ids = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < blocks_count; i++) {
+        self->passed_ids += 1u << blocks[i].free_bits;
+    }
+
+    self->banks_count = 0u;
+    for (i = 0u; i < ARRAY_SIZE(can_filter_kinds); i++) {
+        CanFilterEmit(self, blocks, blocks_count, i);
+    }
+}
+
+uint32_t CanFilterGetFalsePercent(const CanFilterSet *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    if (self->passed_ids == 0u) {
+        return 0u;
+    }
+    return (uint32_t)(((uint64_t)(self->passed_ids - self->wanted_ids) * 100u) / self->passed_ids);
+}
+
+bool CanFilterIsWanted(const CanFilterRange ranges[], size_t count, uint32_t id, bool extended) {
+    /* Check parameters */
+    assert(ranges != NULL);
+
+    size_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        if ((ranges[i].extended == extended) && (id >= ranges[i].first) && (id <= ranges[i].last)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+/* bxCAN filter banks synthesized for a set of wanted identifiers
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_FILTER_H_
+#define CORE_SRC_CAN_FILTER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* The filter register layout in 32-bit scale */
+#define CAN_FILTER_STID_LSB (1u << 21u)
+#define CAN_FILTER_EXID_LSB (1u << 3u)
+#define CAN_FILTER_IDE (1u << 2u)
+
+/* The filter register layout in 16-bit scale, standard identifiers only */
+#define CAN_FILTER16_STID_LSB (1u << 5u)
+#define CAN_FILTER16_IDE (1u << 3u)
+
+#define CAN_FILTER_BANKS_COUNT (14u)
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+    bool extended;
+} CanFilterRange;
+
+typedef enum {
+    CAN_FILTER_MASK_32, /* An extended block */
+    CAN_FILTER_LIST_32, /* 2 extended identifiers */
+    CAN_FILTER_MASK_16, /* 2 standard blocks */
+    CAN_FILTER_LIST_16  /* 4 standard identifiers */
+} CanFilterMode;
+
+/* FR1 and FR2 as the hardware has them. The lists pass the data frames, the masks pass the remote frames too */
+typedef struct {
+    uint32_t fr1;
+    uint32_t fr2;
+    CanFilterMode mode;
+} CanFilterBank;
+
+typedef struct {
+    CanFilterBank banks[CAN_FILTER_BANKS_COUNT];
+    uint32_t banks_count;
+    uint32_t wanted_ids;
+    uint32_t passed_ids; /* Wanted and false positives */
+} CanFilterSet;
+
+/* The ranges must not overlap. They are split into aligned blocks, which are exact. While they need more banks than there are,
+ * the two blocks whose common block adds the fewest false positive identifiers are merged */
+void CanFilterSynthesize(CanFilterSet *self, const CanFilterRange ranges[], size_t count);
+
+/* Percent of the passed identifiers that are not wanted */
+uint32_t CanFilterGetFalsePercent(const CanFilterSet *self);
+
+/* Software check of a received frame. O(count) */
+bool CanFilterIsWanted(const CanFilterRange ranges[], size_t count, uint32_t id, bool extended);
+
+#endif /* CORE_SRC_CAN_FILTER_H_ */
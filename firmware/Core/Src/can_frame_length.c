@@ -0,0 +1,133 @@
+/* Exact on-wire length of a CAN frame
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_frame_length.h"
+#include <assert.h>
+
+#define CAN_FRAME_LENGTH_TAIL_BITS (13u) /* CRC delimiter, ACK slot and delimiter, EOF, intermission */
+#define CAN_FRAME_LENGTH_CRC_BITS (15u)
+#define CAN_FRAME_LENGTH_CRC_POLYNOMIAL (0x4599u)
+#define CAN_FRAME_LENGTH_CRC_MASK (0x7FFFu)
+
+/* CRC-15 of a nibble shifted out of the top of the register */
+static const uint16_t can_frame_length_crc_table[16] = {
+    0x0000u, 0x4599u, 0x4EABu, 0x0B32u, 0x58CFu, 0x1D56u, 0x1664u, 0x53FDu,
+    0x7407u, 0x319Eu, 0x3AACu, 0x7F35u, 0x2CC8u, 0x6951u, 0x6263u, 0x27FAu,
+};
+
+/* Stuffing state: bit 2 is the last level, bits 0..1 are the run length - 1. A run of 5 is never kept,
+ * the stuff bit starts a run of the opposite level. Entry: bit 3 is a stuff bit inserted, bits 0..2 the next state */
+#define CAN_FRAME_LENGTH_STUFF_STATE_MASK (0x07u)
+#define CAN_FRAME_LENGTH_STUFF_BIT (0x08u)
+#define CAN_FRAME_LENGTH_STUFF_IDLE (0x04u) /* Recessive before SOF */
+
+static const uint8_t can_frame_length_stuff_table[8][16] = {
+    {0x0Cu, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x06u, 0x02u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x07u},
+    {0x08u, 0x0Du, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x06u, 0x02u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x07u},
+    {0x09u, 0x0Cu, 0x08u, 0x0Eu, 0x01u, 0x04u, 0x00u, 0x06u, 0x02u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x07u},
+    {0x0Au, 0x0Cu, 0x08u, 0x0Du, 0x09u, 0x0Cu, 0x08u, 0x0Fu, 0x02u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x07u},
+    {0x03u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x06u, 0x02u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x08u},
+    {0x03u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x06u, 0x02u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x09u, 0x0Cu},
+    {0x03u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x06u, 0x02u, 0x04u, 0x00u, 0x05u, 0x0Au, 0x0Cu, 0x08u, 0x0Du},
+    {0x03u, 0x04u, 0x00u, 0x05u, 0x01u, 0x04u, 0x00u, 0x06u, 0x0Bu, 0x0Cu, 0x08u, 0x0Du, 0x09u, 0x0Cu, 0x08u, 0x0Eu},
+};
+
+/* Bits from SOF to the end of CRC, MSB first */
+typedef struct {
+    uint64_t pending;       /* Bits not processed yet, at most 3 between pushes */
+    uint32_t pending_count;
+    uint32_t bits;
+    bool crc_enabled;
+    uint16_t crc;
+    uint8_t stuff_state;
+    uint32_t stuff_bits;
+} CanFrameLengthStream;
+
+static void CanFrameLengthPush(CanFrameLengthStream *self, uint32_t value, uint32_t count) {
+    assert(count <= 32u);
+
+    self->pending = (self->pending << count) | value;
+    self->pending_count += count;
+    self->bits += count;
+    while (self->pending_count >= 4u) {
+        self->pending_count -= 4u;
+        const uint32_t nibble = (uint32_t)(self->pending >> self->pending_count) & 0x0Fu;
+        if (self->crc_enabled) {
+            self->crc = (uint16_t)(((uint32_t)self->crc << 4u) ^
+                                   can_frame_length_crc_table[((uint32_t)self->crc >> 11u) ^ nibble]) &
+                        CAN_FRAME_LENGTH_CRC_MASK;
+        }
+        const uint8_t entry = can_frame_length_stuff_table[self->stuff_state][nibble];
+        self->stuff_bits += ((entry & CAN_FRAME_LENGTH_STUFF_BIT) != 0u) ? 1u : 0u;
+        self->stuff_state = entry & CAN_FRAME_LENGTH_STUFF_STATE_MASK;
+    }
+}
+
+/* The pending bits stay for the stuffing */
+static void CanFrameLengthFinishCrc(CanFrameLengthStream *self) {
+    uint32_t i = 0u;
+    for (i = self->pending_count; i > 0u; i--) {
+        const uint32_t bit = (uint32_t)(self->pending >> (i - 1u)) & 1u;
+        const uint32_t feedback = bit ^ ((uint32_t)self->crc >> 14u);
+        self->crc = (uint16_t)((uint32_t)self->crc << 1u) & CAN_FRAME_LENGTH_CRC_MASK;
+        if (feedback != 0u) {
+            self->crc ^= CAN_FRAME_LENGTH_CRC_POLYNOMIAL;
+        }
+    }
+    self->crc_enabled = false;
+}
+
+static void CanFrameLengthFinishStuffing(CanFrameLengthStream *self) {
+    uint32_t level = ((uint32_t)self->stuff_state >> 2u) & 1u;
+    uint32_t run = ((uint32_t)self->stuff_state & 3u) + 1u;
+    uint32_t i = 0u;
+    for (i = self->pending_count; i > 0u; i--) {
+        const uint32_t bit = (uint32_t)(self->pending >> (i - 1u)) & 1u;
+        if (bit == level) {
+            run++;
+        } else {
+            level = bit;
+            run = 1u;
+        }
+        if (run == 5u) {
+            self->stuff_bits++;
+            level ^= 1u;
+            run = 1u;
+        }
+    }
+    self->pending_count = 0u;
+}
+
+uint32_t CanFrameLengthGet(uint32_t id, bool extended, bool rtr, uint8_t dlc, const uint8_t data[]) {
+    /* Check parameters */
+    assert(dlc <= 15u);
+
+    CanFrameLengthStream stream = {0};
+    stream.crc_enabled = true;
+    stream.stuff_state = CAN_FRAME_LENGTH_STUFF_IDLE;
+    const uint32_t rtr_bit = rtr ? 1u : 0u;
+
+    /* SOF is the leading dominant bit of the first push */
+    if (extended) {
+        CanFrameLengthPush(&stream, (((id >> 18u) & 0x7FFu) << 2u) | 3u, 14u);                /* ID A, SRR, IDE */
+        CanFrameLengthPush(&stream, ((id & 0x3FFFFu) << 7u) | (rtr_bit << 6u) | dlc, 25u); /* ID B, RTR, r1, r0, DLC */
+    } else {
+        CanFrameLengthPush(&stream, ((id & 0x7FFu) << 7u) | (rtr_bit << 6u) | dlc, 19u); /* ID, RTR, IDE, r0, DLC */
+    }
+
+    const uint32_t data_size = rtr ? 0u : ((dlc > 8u) ? 8u : dlc);
+    assert((data_size == 0u) || (data != NULL));
+    uint32_t i = 0u;
+    for (i = 0u; i < data_size; i++) {
+        CanFrameLengthPush(&stream, data[i], 8u);
+    }
+
+    CanFrameLengthFinishCrc(&stream);
+    CanFrameLengthPush(&stream, stream.crc, CAN_FRAME_LENGTH_CRC_BITS);
+    CanFrameLengthFinishStuffing(&stream);
+
+    return stream.bits + stream.stuff_bits + CAN_FRAME_LENGTH_TAIL_BITS;
+}
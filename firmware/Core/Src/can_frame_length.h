@@ -0,0 +1,18 @@
+/* Exact on-wire length of a CAN frame
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_FRAME_LENGTH_H_
+#define CORE_SRC_CAN_FRAME_LENGTH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Bits from SOF to the end of intermission, including the stuff bits of the actual identifier, data and CRC.
+ * DLC 9..15 carries 8 bytes, an RTR frame none. Table driven, a nibble per step */
+uint32_t CanFrameLengthGet(uint32_t id, bool extended, bool rtr, uint8_t dlc, const uint8_t data[]);
+
+#endif /* CORE_SRC_CAN_FRAME_LENGTH_H_ */
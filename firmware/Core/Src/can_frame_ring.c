@@ -0,0 +1,38 @@
+/* Lock-free single producer single consumer ring of received CAN frames
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_frame_ring.h"
+#include <assert.h>
+#include <string.h>
+
+#if (CAN_FRAME_RING_SIZE & (CAN_FRAME_RING_SIZE - 1u)) != 0u
+#error CAN_FRAME_RING_SIZE must be a power of two
+#endif
+
+void CanFrameRingInit(CanFrameRing *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+size_t CanFrameRingRead(CanFrameRing *self, CanFrameRecord records[], size_t max_count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((records != NULL) || (max_count == 0u));
+
+    const uint32_t tail = self->tail;
+    const uint32_t available = self->head - tail;
+    CAN_FRAME_RING_BARRIER();
+    const size_t count = (available < max_count) ? available : max_count;
+    size_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        records[i] = self->records[(tail + i) & (CAN_FRAME_RING_SIZE - 1u)];
+    }
+    CAN_FRAME_RING_BARRIER();
+    self->tail = tail + (uint32_t)count;
+    return count;
+}
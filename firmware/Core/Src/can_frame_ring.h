@@ -0,0 +1,68 @@
+/* Lock-free single producer single consumer ring of received CAN frames
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_FRAME_RING_H_
+#define CORE_SRC_CAN_FRAME_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* Frame flags */
+#define CAN_FRAME_EXTENDED (0x01u)
+#define CAN_FRAME_RTR (0x02u)
+
+#define CAN_FRAME_MAX_DATA (8u)
+
+/* Received frame, 20 bytes. The data is word aligned for the register-level reads */
+typedef struct {
+    uint32_t time; /* DWT->CYCCNT at the interrupt entry */
+    uint32_t id;
+    uint8_t data[CAN_FRAME_MAX_DATA];
+    uint8_t dlc;
+    uint8_t flags;
+} CanFrameRecord;
+
+/* The producer (the CAN RX interrupt) only writes head, the consumer (the main loop) only writes tail.
+ * Both are free running, the size is a power of two. */
+typedef struct {
+    CanFrameRecord records[CAN_FRAME_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t overruns;   /* Frames dropped because the ring was full, written by the producer */
+    uint32_t high_water; /* Max frames in the ring, written by the producer */
+} CanFrameRing;
+
+/* Single core: only the compiler may reorder the stores */
+#define CAN_FRAME_RING_BARRIER() __asm__ volatile("" ::: "memory")
+
+void CanFrameRingInit(CanFrameRing *self);
+
+/* Producer. Returns the record to fill or NULL when the ring is full. The push ends with CanFrameRingEndPush */
+static inline CanFrameRecord *CanFrameRingBeginPush(CanFrameRing *self) {
+    const uint32_t head = self->head;
+    if ((head - self->tail) >= CAN_FRAME_RING_SIZE) {
+        self->overruns++;
+        return NULL;
+    }
+    return &self->records[head & (CAN_FRAME_RING_SIZE - 1u)];
+}
+
+static inline void CanFrameRingEndPush(CanFrameRing *self) {
+    const uint32_t head = self->head + 1u;
+    CAN_FRAME_RING_BARRIER();
+    self->head = head;
+    const uint32_t used = head - self->tail;
+    if (used > self->high_water) {
+        self->high_water = used;
+    }
+}
+
+/* Consumer. Copies up to max_count oldest frames, returns the count */
+size_t CanFrameRingRead(CanFrameRing *self, CanFrameRecord records[], size_t max_count);
+
+#endif /* CORE_SRC_CAN_FRAME_RING_H_ */
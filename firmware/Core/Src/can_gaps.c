@@ -0,0 +1,67 @@
+/* Inter-frame gap histogram and back-to-back burst detection
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_gaps.h"
+#include <assert.h>
+#include <string.h>
+
+#define CAN_GAPS_WORD_BITS (32u)
+
+void CanGapsInit(CanGaps *self, uint32_t bit_time) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(bit_time > 0u);
+
+    (void)memset(self, 0, sizeof(*self));
+    self->bit_time = bit_time;
+}
+
+void CanGapsResync(CanGaps *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->prev_end_time_valid = false;
+    self->burst_length = 0u;
+}
+
+void CanGapsSetBitTime(CanGaps *self, uint32_t bit_time) {
+    CanGapsInit(self, bit_time);
+}
+
+void CanGapsAddFrame(CanGaps *self, uint32_t start_time, uint32_t end_time) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    if (self->prev_end_time_valid) {
+        /* SOF is allowed in the last bit of intermission */
+        const int32_t gap = (int32_t)(start_time - self->prev_end_time);
+        const uint32_t bits = (gap > 0) ? (((uint32_t)gap + (self->bit_time / 2u)) / self->bit_time) : 0u;
+        uint32_t bin = 0u;
+        if (bits != 0u) {
+            bin = CAN_GAPS_WORD_BITS - (uint32_t)__builtin_clz(bits); /* CLZ instruction */
+            if (bin >= CAN_GAPS_BINS_COUNT) {
+                bin = CAN_GAPS_BINS_COUNT - 1u;
+            }
+        }
+        self->bins[bin]++;
+
+        if (bits == 0u) {
+            self->burst_length++;
+            if (self->burst_length == 2u) {
+                self->bursts++;
+            }
+            if (self->burst_length > self->max_burst_length) {
+                self->max_burst_length = self->burst_length;
+            }
+        } else {
+            self->burst_length = 1u;
+        }
+    } else {
+        self->burst_length = 1u;
+    }
+    self->prev_end_time = end_time;
+    self->prev_end_time_valid = true;
+}
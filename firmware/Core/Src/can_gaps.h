@@ -0,0 +1,39 @@
+/* Inter-frame gap histogram and back-to-back burst detection
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_GAPS_H_
+#define CORE_SRC_CAN_GAPS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Bin 0 is back-to-back (less than a bit between the intermission and SOF),
+ * bin N is [2^(N-1), 2^N) bits, the last bin is everything longer */
+#define CAN_GAPS_BINS_COUNT (16u)
+
+typedef struct {
+    uint32_t bit_time; /* CPU ticks */
+    uint32_t prev_end_time;
+    bool prev_end_time_valid;
+    uint32_t bins[CAN_GAPS_BINS_COUNT];
+    uint32_t burst_length;     /* Frames in the current back-to-back train */
+    uint32_t max_burst_length; /* Longest train */
+    uint32_t bursts;           /* Trains of 2 or more frames */
+} CanGaps;
+
+void CanGapsInit(CanGaps *self, uint32_t bit_time);
+
+/* Forget the previous frame, e.g. after lost edges */
+void CanGapsResync(CanGaps *self);
+
+/* Change the bit rate at runtime, the statistics are cleared */
+void CanGapsSetBitTime(CanGaps *self, uint32_t bit_time);
+
+/* Decoded frame, CPU ticks from SOF to the end of intermission. O(1) */
+void CanGapsAddFrame(CanGaps *self, uint32_t start_time, uint32_t end_time);
+
+#endif /* CORE_SRC_CAN_GAPS_H_ */
@@ -0,0 +1,26 @@
+/* Dominant time measurement by a timer in gated slave mode
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_GATED_H_
+#define CORE_SRC_CAN_GATED_H_
+
+#include <stdint.h>
+
+/* The timer counts CPU ticks only while PA15 is low (dominant). The hardware integrates the
+ * dominant time, there are no interrupts except one per 65536 dominant ticks. */
+typedef struct {
+    volatile uint32_t overflows;
+} CanGated;
+
+/* Start timer */
+void CanGatedInit(CanGated *self);
+
+/* Call from TIM2_IRQHandler */
+void CanGatedIrqHandler(CanGated *self);
+
+/* Dominant time since init, CPU ticks */
+uint32_t CanGatedGetTime(CanGated *self);
+
+#endif /* CORE_SRC_CAN_GATED_H_ */
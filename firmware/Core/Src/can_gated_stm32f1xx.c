@@ -0,0 +1,73 @@
+/* Dominant time measurement by a timer in gated slave mode
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include "can_gated.h"
+#include "stm32f1xx_hal.h"
+
+/* PA15 is TIM2_CH1 with the partial remap 1. The timer clock is 2 * PCLK1 = 64 MHz = CPU clock. */
+
+#define CAN_GATED_TIMER TIM2
+#define CAN_GATED_TIMER_IRQ TIM2_IRQn
+#define CAN_GATED_TIMER_BITS (16u)
+#define CAN_GATED_TIMER_HALF_PERIOD (0x8000u)
+
+void CanGatedInit(CanGated *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->overflows = 0u;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    /* TIM2 partial remap 1. Don't use __HAL_AFIO_REMAP_TIM2_PARTIAL_1, it switches SWD off. */
+    AFIO->MAPR = (AFIO->MAPR & ~(AFIO_MAPR_TIM2_REMAP | AFIO_MAPR_SWJ_CFG)) | AFIO_MAPR_TIM2_REMAP_PARTIALREMAP1 |
+                 AFIO_MAPR_SWJ_CFG_JTAGDISABLE;
+
+    /* Timer: TI1FP1 inverted (high while dominant) gates the counter, interrupt on overflow */
+    CAN_GATED_TIMER->CR1 = TIM_CR1_URS;
+    CAN_GATED_TIMER->PSC = 0u;
+    CAN_GATED_TIMER->ARR = UINT16_MAX;
+    CAN_GATED_TIMER->CCMR1 = TIM_CCMR1_CC1S_0;
+    CAN_GATED_TIMER->CCER = TIM_CCER_CC1P;
+    CAN_GATED_TIMER->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_TS_0 | TIM_SMCR_SMS_2 | TIM_SMCR_SMS_0; /* TI1FP1, gated */
+    CAN_GATED_TIMER->CNT = 0u;
+    CAN_GATED_TIMER->SR = 0u;
+    CAN_GATED_TIMER->DIER = TIM_DIER_UIE;
+    HAL_NVIC_SetPriority(CAN_GATED_TIMER_IRQ, 0, 0);
+    HAL_NVIC_EnableIRQ(CAN_GATED_TIMER_IRQ);
+    CAN_GATED_TIMER->CR1 = TIM_CR1_URS | TIM_CR1_CEN;
+}
+
+void CanGatedIrqHandler(CanGated *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    if ((CAN_GATED_TIMER->SR & TIM_SR_UIF) != 0u) {
+        CAN_GATED_TIMER->SR = (uint32_t)~TIM_SR_UIF;
+        self->overflows++;
+    }
+}
+
+uint32_t CanGatedGetTime(CanGated *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    uint32_t overflows = 0u;
+    uint32_t counter = 0u;
+    bool overflow_pending = false;
+    do {
+        overflows = self->overflows;
+        counter = CAN_GATED_TIMER->CNT;
+        /* The counter has wrapped, but the interrupt has not run yet */
+        overflow_pending =
+            ((CAN_GATED_TIMER->SR & TIM_SR_UIF) != 0u) && (counter < CAN_GATED_TIMER_HALF_PERIOD);
+    } while (overflows != self->overflows);
+    if (overflow_pending) {
+        overflows++;
+    }
+    return (overflows << CAN_GATED_TIMER_BITS) + counter;
+}
@@ -0,0 +1,68 @@
+/* Rejection of pulses shorter than a part of the bit time
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_glitch.h"
+#include <assert.h>
+#include <string.h>
+
+void CanGlitchInit(CanGlitch *self, uint32_t bit_time, uint32_t min_width_percent) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(min_width_percent < 100u);
+
+    (void)memset(self, 0, sizeof(*self));
+    self->min_width_percent = min_width_percent;
+    CanGlitchSetBitTime(self, bit_time);
+}
+
+void CanGlitchSetBitTime(CanGlitch *self, uint32_t bit_time) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->min_width = (bit_time * self->min_width_percent) / 100u;
+    CanGlitchResync(self);
+}
+
+void CanGlitchResync(CanGlitch *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->pending_valid = false;
+    self->prev_falling_time_valid = false;
+}
+
+size_t CanGlitchFilter(CanGlitch *self, CanEdge edges[], size_t count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((edges != NULL) || (count == 0u));
+
+    /* At most one edge is written per edge read, so the output never overtakes the input */
+    const uint32_t min_width = self->min_width;
+    CanEdge pending = self->pending;
+    bool pending_valid = self->pending_valid;
+    uint32_t glitches = self->glitches;
+    size_t out = 0u;
+    size_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        const CanEdge edge = edges[i];
+        if (pending_valid == false) {
+            pending = edge;
+            pending_valid = true;
+        } else if ((CanEdgeTime(edge) - CanEdgeTime(pending)) < min_width) {
+            /* Both edges of the pulse are dropped, the level before it continues */
+            pending_valid = false;
+            glitches++;
+        } else {
+            edges[out] = pending;
+            out++;
+            pending = edge;
+        }
+    }
+    self->pending = pending;
+    self->pending_valid = pending_valid;
+    self->glitches = glitches;
+    return out;
+}
@@ -0,0 +1,54 @@
+/* Rejection of pulses shorter than a part of the bit time
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_GLITCH_H_
+#define CORE_SRC_CAN_GLITCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_edge.h"
+
+typedef struct {
+    uint32_t min_width_percent; /* Of the bit time */
+    uint32_t min_width;         /* CPU ticks */
+    CanEdge pending;            /* Output once the next edge shows it is not a glitch */
+    bool pending_valid;
+    uint32_t prev_falling_time; /* Falling only stream */
+    bool prev_falling_time_valid;
+    uint32_t glitches; /* Rejected pulses */
+} CanGlitch;
+
+void CanGlitchInit(CanGlitch *self, uint32_t bit_time, uint32_t min_width_percent);
+
+/* Change the bit rate at runtime */
+void CanGlitchSetBitTime(CanGlitch *self, uint32_t bit_time);
+
+/* Forget the previous edge, e.g. after lost edges */
+void CanGlitchResync(CanGlitch *self);
+
+/* Both edges in time order. A pulse shorter than min_width is removed with both its edges.
+ * Filters in place, O(1) per edge, the output is one edge behind. Returns the new count. */
+size_t CanGlitchFilter(CanGlitch *self, CanEdge edges[], size_t count);
+
+/* The output has all edges up to this time */
+static inline uint32_t CanGlitchGetTime(const CanGlitch *self, uint32_t now) {
+    return self->pending_valid ? CanEdgeTime(self->pending) : now;
+}
+
+/* Falling edges only, e.g. from EXTI. A falling period holds a dominant and a recessive pulse,
+ * so a shorter period than 2 * min_width has a glitch, its second edge is rejected. */
+static inline bool CanGlitchAcceptFalling(CanGlitch *self, uint32_t time) {
+    if (self->prev_falling_time_valid && ((time - self->prev_falling_time) < (self->min_width * 2u))) {
+        self->glitches++;
+        return false;
+    }
+    self->prev_falling_time = time;
+    self->prev_falling_time_valid = true;
+    return true;
+}
+
+#endif /* CORE_SRC_CAN_GLITCH_H_ */
@@ -0,0 +1,68 @@
+/* Edge interrupt rate limiting under interrupt storms
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_governor.h"
+#include <assert.h>
+
+#define CAN_GOVERNOR_MIN_ON_SHIFT (4u) /* At least 1/16 of every window is sampled */
+
+void CanGovernorInit(CanGovernor *self, uint32_t window, uint32_t max_percent, uint32_t target_percent, uint32_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(window > 0u);
+    assert(target_percent > 0u);
+    assert(target_percent <= max_percent);
+
+    self->window = window;
+    self->max_percent = max_percent;
+    self->target_percent = target_percent;
+    self->window_start = now;
+    self->on_time = window;
+    self->isr_cycles = 0u;
+    self->masked = false;
+}
+
+bool CanGovernorUpdate(CanGovernor *self, uint32_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    if ((now - self->window_start) < self->window) {
+        return false;
+    }
+
+    /* Interrupt load while it was enabled */
+    const uint64_t isr_load = (uint64_t)self->isr_cycles * 100u;
+    const bool sampling = CanGovernorIsSampling(self);
+    if ((sampling == false) && (isr_load <= ((uint64_t)self->max_percent * self->window))) {
+        /* Normal */
+    } else if (sampling && (isr_load < ((uint64_t)self->target_percent * self->on_time))) {
+        self->on_time = self->window; /* The storm has ended */
+    } else {
+        /* on_time * (isr_load / on_time) / 100 = target_percent * window / 100 */
+        const uint64_t on_time = ((uint64_t)self->target_percent * self->window * self->on_time) / isr_load;
+        const uint32_t min_on_time = self->window >> CAN_GOVERNOR_MIN_ON_SHIFT;
+        if (on_time < min_on_time) {
+            self->on_time = min_on_time;
+        } else if (on_time > self->window) {
+            self->on_time = self->window;
+        } else {
+            self->on_time = (uint32_t)on_time;
+        }
+    }
+
+    self->window_start = now;
+    self->isr_cycles = 0u;
+    const bool masked = self->masked;
+    self->masked = false;
+    return masked;
+}
+
+uint32_t CanGovernorGetCoverage(const CanGovernor *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    return (uint32_t)(((uint64_t)self->on_time * 100u) / self->window);
+}
@@ -0,0 +1,52 @@
+/* Edge interrupt rate limiting under interrupt storms
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_GOVERNOR_H_
+#define CORE_SRC_CAN_GOVERNOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Measures the CPU time spent in the edge interrupt per window. Above max_percent the interrupt is enabled only
+ * for the first part of every window (duty-cycled sampling), sized so that it takes about target_percent.
+ * Full rate returns when the interrupt would take less than target_percent at full rate.
+ * Used from interrupts of the same priority only. */
+typedef struct {
+    uint32_t window; /* CPU ticks */
+    uint32_t max_percent;
+    uint32_t target_percent;
+    uint32_t window_start;
+    uint32_t on_time;    /* CPU ticks of every window with the interrupt enabled */
+    uint32_t isr_cycles; /* In the current window */
+    bool masked;
+} CanGovernor;
+
+void CanGovernorInit(CanGovernor *self, uint32_t window, uint32_t max_percent, uint32_t target_percent, uint32_t now);
+
+/* Call on every interrupt with its start time and duration. Returns false if the interrupt must be masked
+ * till the next window. */
+static inline bool CanGovernorAddIsr(CanGovernor *self, uint32_t start, uint32_t cycles) {
+    self->isr_cycles += cycles;
+    if ((start - self->window_start) < self->on_time) {
+        return true;
+    }
+    self->masked = true;
+    return false;
+}
+
+/* Call periodically, more often than the window. Returns true when the interrupt must be unmasked */
+bool CanGovernorUpdate(CanGovernor *self, uint32_t now);
+
+static inline bool CanGovernorIsSampling(const CanGovernor *self) {
+    return self->on_time < self->window;
+}
+
+/* Percent of time with the interrupt enabled. The load measured over this part can differ from the real one by
+ * up to 100 - coverage percent */
+uint32_t CanGovernorGetCoverage(const CanGovernor *self);
+
+#endif /* CORE_SRC_CAN_GOVERNOR_H_ */
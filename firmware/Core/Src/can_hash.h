@@ -0,0 +1,22 @@
+/* Hash of the identifiers for the open addressing tables
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_HASH_H_
+#define CORE_SRC_CAN_HASH_H_
+
+#include <stdint.h>
+
+#define CAN_HASH_MULTIPLIER (2654435761u) /* Knuth */
+#define CAN_HASH_WORD_BITS (32u)
+
+/* Home slot of a table of size slots, a power of two. The high bits of the product depend on every bit of the key,
+ * the low bits only on the low bits of the key, so identifiers with equal low bits would share a slot */
+static inline uint32_t CanHash(uint32_t key, uint32_t size) {
+    const uint32_t bits = (uint32_t)__builtin_ctz(size); /* Constant for a constant size */
+    return (bits == 0u) ? 0u : ((key * CAN_HASH_MULTIPLIER) >> (CAN_HASH_WORD_BITS - bits));
+}
+
+#endif /* CORE_SRC_CAN_HASH_H_ */
@@ -0,0 +1,157 @@
+/* Multi-resolution bus load history
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_history.h"
+#include <assert.h>
+#include <string.h>
+
+#define CAN_HISTORY_SECONDS_PER_MINUTE (60u)
+#define CAN_HISTORY_PERCENT_MAX (100u)
+#define CAN_HISTORY_STEP_MAX (CAN_HISTORY_BUCKET_STEPS - 1u)
+#define CAN_HISTORY_STEP_BITS (5u)
+#define CAN_HISTORY_STEP_MASK ((1u << CAN_HISTORY_STEP_BITS) - 1u)
+
+static const uint16_t can_history_sizes[CAN_HISTORY_LEVELS_COUNT] = {
+    CAN_HISTORY_SAMPLES_SIZE, CAN_HISTORY_SECONDS_SIZE, CAN_HISTORY_MINUTES_SIZE};
+
+/* Entries of the finer level per entry of the next level */
+static const uint8_t can_history_ratios[CAN_HISTORY_LEVELS_COUNT - 1u] = {
+    CAN_HISTORY_SAMPLES_PER_SECOND, CAN_HISTORY_SECONDS_PER_MINUTE};
+
+/* Rounded to the nearest step, 0 and 100 % stay exact */
+static uint32_t CanHistoryToStep(uint8_t percent) {
+    const uint32_t value = (percent < CAN_HISTORY_PERCENT_MAX) ? percent : CAN_HISTORY_PERCENT_MAX;
+    return ((value * CAN_HISTORY_STEP_MAX) + (CAN_HISTORY_PERCENT_MAX / 2u)) / CAN_HISTORY_PERCENT_MAX;
+}
+
+static uint8_t CanHistoryToPercent(uint32_t step) {
+    return (uint8_t)(((step * CAN_HISTORY_PERCENT_MAX) + (CAN_HISTORY_STEP_MAX / 2u)) / CAN_HISTORY_STEP_MAX);
+}
+
+/* Avg, min and max in 5 bits each */
+static uint16_t CanHistoryPack(const CanHistoryBucket *bucket) {
+    return (uint16_t)((CanHistoryToStep(bucket->avg) << (2u * CAN_HISTORY_STEP_BITS)) |
+                      (CanHistoryToStep(bucket->min) << CAN_HISTORY_STEP_BITS) | CanHistoryToStep(bucket->max));
+}
+
+static void CanHistoryUnpack(uint16_t packed, CanHistoryBucket *bucket) {
+    bucket->avg = CanHistoryToPercent(((uint32_t)packed >> (2u * CAN_HISTORY_STEP_BITS)) & CAN_HISTORY_STEP_MASK);
+    bucket->min = CanHistoryToPercent(((uint32_t)packed >> CAN_HISTORY_STEP_BITS) & CAN_HISTORY_STEP_MASK);
+    bucket->max = CanHistoryToPercent((uint32_t)packed & CAN_HISTORY_STEP_MASK);
+}
+
+void CanHistoryInit(CanHistory *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+/* Returns the position of the new entry */
+static uint32_t CanHistoryPush(CanHistory *self, uint32_t level) {
+    const uint32_t position = self->positions[level];
+    const uint32_t next = position + 1u;
+    self->positions[level] = (uint16_t)((next < can_history_sizes[level]) ? next : 0u);
+    if (self->counts[level] < can_history_sizes[level]) {
+        self->counts[level]++;
+    }
+    return position;
+}
+
+static void CanHistoryAccumulate(CanHistoryAccumulator *accumulator, const CanHistoryBucket *bucket) {
+    if (accumulator->count == 0u) {
+        accumulator->sum = 0u;
+        accumulator->min = bucket->min;
+        accumulator->max = bucket->max;
+    } else {
+        if (bucket->min < accumulator->min) {
+            accumulator->min = bucket->min;
+        }
+        if (bucket->max > accumulator->max) {
+            accumulator->max = bucket->max;
+        }
+    }
+    accumulator->sum += bucket->avg;
+    accumulator->count++;
+}
+
+void CanHistoryAdd(CanHistory *self, uint8_t percent) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->samples[CanHistoryPush(self, CAN_HISTORY_SAMPLES)] = percent;
+
+    /* Each finer bucket is folded into the coarser one, at most once per level */
+    CanHistoryBucket bucket = {percent, percent, percent};
+    uint32_t level = 0u;
+    for (level = 0u; level < (CAN_HISTORY_LEVELS_COUNT - 1u); level++) {
+        CanHistoryAccumulator *accumulator = &self->accumulators[level];
+        CanHistoryAccumulate(accumulator, &bucket);
+        if (accumulator->count < can_history_ratios[level]) {
+            break;
+        }
+        bucket.avg = (uint8_t)((accumulator->sum + (accumulator->count / 2u)) / accumulator->count);
+        bucket.min = accumulator->min;
+        bucket.max = accumulator->max;
+        accumulator->count = 0u;
+        /* The next level accumulates the exact bucket */
+        uint16_t *buckets = (level == 0u) ? self->seconds : self->minutes;
+        buckets[CanHistoryPush(self, level + 1u)] = CanHistoryPack(&bucket);
+    }
+}
+
+uint32_t CanHistoryGetCount(const CanHistory *self, uint32_t level) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(level < CAN_HISTORY_LEVELS_COUNT);
+
+    return self->counts[level];
+}
+
+bool CanHistoryGet(const CanHistory *self, uint32_t level, uint32_t age, CanHistoryBucket *result) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(level < CAN_HISTORY_LEVELS_COUNT);
+    assert(result != NULL);
+
+    if (age >= self->counts[level]) {
+        return false;
+    }
+    const uint32_t size = can_history_sizes[level];
+    const uint32_t position = self->positions[level];
+    const uint32_t index = (position > age) ? (position - age - 1u) : ((position + size) - age - 1u);
+    if (level == CAN_HISTORY_SAMPLES) {
+        const uint8_t sample = self->samples[index];
+        result->avg = sample;
+        result->min = sample;
+        result->max = sample;
+    } else {
+        CanHistoryUnpack((level == CAN_HISTORY_SECONDS) ? self->seconds[index] : self->minutes[index], result);
+    }
+    return true;
+}
+
+bool CanHistorySummary(const CanHistory *self, uint32_t level, uint32_t age, uint32_t count,
+                       CanHistoryBucket *result) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(level < CAN_HISTORY_LEVELS_COUNT);
+    assert(result != NULL);
+
+    CanHistoryAccumulator accumulator = {0};
+    CanHistoryBucket bucket;
+    uint32_t i = 0u;
+    for (i = 0u; (i < count) && CanHistoryGet(self, level, age + i, &bucket); i++) {
+        CanHistoryAccumulate(&accumulator, &bucket);
+    }
+    if (accumulator.count == 0u) {
+        return false;
+    }
+    result->avg = (uint8_t)((accumulator.sum + (i / 2u)) / i);
+    result->min = accumulator.min;
+    result->max = accumulator.max;
+    return true;
+}
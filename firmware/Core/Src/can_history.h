@@ -0,0 +1,65 @@
+/* Multi-resolution bus load history
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_HISTORY_H_
+#define CORE_SRC_CAN_HISTORY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* Levels, from the finest */
+#define CAN_HISTORY_SAMPLES (0u) /* Every sample, CAN_HISTORY_SAMPLES_SIZE */
+#define CAN_HISTORY_SECONDS (1u) /* CAN_HISTORY_SAMPLES_PER_SECOND samples per bucket */
+#define CAN_HISTORY_MINUTES (2u) /* 60 seconds per bucket */
+#define CAN_HISTORY_LEVELS_COUNT (3u)
+
+/* Load in percent. The buckets of the seconds and minutes levels are stored in CAN_HISTORY_BUCKET_STEPS steps,
+ * one step is a point of the graph */
+#define CAN_HISTORY_BUCKET_STEPS (32u)
+
+typedef struct {
+    uint8_t avg;
+    uint8_t min;
+    uint8_t max;
+} CanHistoryBucket;
+
+/* Bucket being filled */
+typedef struct {
+    uint32_t sum;
+    uint8_t min;
+    uint8_t max;
+    uint16_t count;
+} CanHistoryAccumulator;
+
+/* Ring buffers, the newest entry is at position - 1 */
+typedef struct {
+    uint8_t samples[CAN_HISTORY_SAMPLES_SIZE]; /* A single sample has avg = min = max */
+    uint16_t seconds[CAN_HISTORY_SECONDS_SIZE]; /* Packed CanHistoryBucket */
+    uint16_t minutes[CAN_HISTORY_MINUTES_SIZE];
+    uint16_t positions[CAN_HISTORY_LEVELS_COUNT];
+    uint16_t counts[CAN_HISTORY_LEVELS_COUNT];
+    CanHistoryAccumulator accumulators[CAN_HISTORY_LEVELS_COUNT - 1u]; /* For seconds and minutes */
+} CanHistory;
+
+void CanHistoryInit(CanHistory *self);
+
+/* Add a sample every 1 / CAN_HISTORY_SAMPLES_PER_SECOND seconds, O(1) */
+void CanHistoryAdd(CanHistory *self, uint8_t percent);
+
+/* Number of stored entries of the level */
+uint32_t CanHistoryGetCount(const CanHistory *self, uint32_t level);
+
+/* Entry of the level, age 0 is the newest. Returns false if there is no such entry */
+bool CanHistoryGet(const CanHistory *self, uint32_t level, uint32_t age, CanHistoryBucket *result);
+
+/* Avg, min and max of count entries of the level from age on, e.g. the peak of the last 10 seconds
+ * or a column of a trend graph. Returns false if there is no entry */
+bool CanHistorySummary(const CanHistory *self, uint32_t level, uint32_t age, uint32_t count,
+                       CanHistoryBucket *result);
+
+#endif /* CORE_SRC_CAN_HISTORY_H_ */
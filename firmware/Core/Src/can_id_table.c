@@ -0,0 +1,142 @@
+/* Per identifier statistics in a fixed size hash table
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_id_table.h"
+#include "can_hash.h"
+#include <assert.h>
+#include <string.h>
+
+#if (CAN_ID_TABLE_SIZE & (CAN_ID_TABLE_SIZE - 1u)) != 0u
+#error CAN_ID_TABLE_SIZE must be a power of two
+#endif
+
+#if CAN_ID_TABLE_MAX_PROBES > CAN_ID_TABLE_SIZE
+#error CAN_ID_TABLE_MAX_PROBES is larger than the table
+#endif
+
+#define CAN_ID_TABLE_AVERAGE_SHIFT (3u) /* The moving averages follow 1/8 of every change */
+#define CAN_ID_TABLE_BITS_LIMIT (0x80000000u)
+
+void CanIdTableInit(CanIdTable *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ID_TABLE_SIZE; i++) {
+        self->entries[i].key = CAN_ID_TABLE_EMPTY;
+    }
+}
+
+/* The entry to replace, true if victim is worse than candidate */
+static inline bool CanIdTableIsWorse(const CanIdStats *victim, const CanIdStats *candidate) {
+#if CAN_ID_TABLE_EVICTION == CAN_ID_TABLE_EVICT_LRU
+    return victim->last_time < candidate->last_time;
+#else
+    return victim->frames < candidate->frames;
+#endif
+}
+
+static void CanIdTableStart(CanIdStats *entry, uint32_t key, uint64_t time) {
+    (void)memset(entry, 0, sizeof(*entry));
+    entry->key = key;
+    entry->last_time = time;
+    entry->min_period = UINT32_MAX;
+}
+
+static void CanIdTableAccount(CanIdStats *entry, uint64_t time, uint32_t payload_bytes, uint32_t bus_bits) {
+    if (entry->frames != 0u) {
+        const uint64_t period64 = time - entry->last_time;
+        const uint32_t period = (period64 < UINT32_MAX) ? (uint32_t)period64 : UINT32_MAX;
+        if (period < entry->min_period) {
+            entry->min_period = period;
+        }
+        if (period > entry->max_period) {
+            entry->max_period = period;
+        }
+        if (entry->frames == 1u) {
+            entry->mean_period = period;
+        } else {
+            const int32_t deviation = (int32_t)(period - entry->mean_period);
+            entry->mean_period += (uint32_t)(deviation >> CAN_ID_TABLE_AVERAGE_SHIFT);
+            const uint32_t abs_deviation = (deviation < 0) ? (uint32_t)-deviation : (uint32_t)deviation;
+            const int32_t jitter_change = (int32_t)(abs_deviation - entry->jitter);
+            entry->jitter += (uint32_t)(jitter_change >> CAN_ID_TABLE_AVERAGE_SHIFT);
+        }
+    }
+    entry->last_time = time;
+    entry->frames++;
+    entry->payload_bytes += payload_bytes;
+    entry->bus_bits += bus_bits;
+}
+
+/* Keeps the shares of the bus time, older traffic weighs less */
+static void CanIdTableHalveBits(CanIdTable *self) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ID_TABLE_SIZE; i++) {
+        self->entries[i].bus_bits /= 2u;
+    }
+    self->bus_bits_total /= 2u;
+}
+
+CanIdStats *CanIdTableAdd(CanIdTable *self, uint32_t key, uint64_t time, uint32_t payload_bytes, uint32_t bus_bits) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(key != CAN_ID_TABLE_EMPTY);
+
+    if ((self->bus_bits_total + bus_bits) >= CAN_ID_TABLE_BITS_LIMIT) {
+        CanIdTableHalveBits(self);
+    }
+    self->bus_bits_total += bus_bits;
+
+    uint32_t index = CanHash(key, CAN_ID_TABLE_SIZE);
+    CanIdStats *victim = &self->entries[index];
+    CanIdStats *entry = NULL;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ID_TABLE_MAX_PROBES; i++) {
+        CanIdStats *candidate = &self->entries[index];
+        if (candidate->key == key) {
+            entry = candidate;
+            break;
+        }
+        if (candidate->key == CAN_ID_TABLE_EMPTY) {
+            CanIdTableStart(candidate, key, time);
+            self->count++;
+            entry = candidate;
+            break;
+        }
+        if (CanIdTableIsWorse(candidate, victim)) {
+            victim = candidate;
+        }
+        index = (index + 1u) & (CAN_ID_TABLE_SIZE - 1u);
+    }
+    if (entry == NULL) {
+        CanIdTableStart(victim, key, time);
+        self->evictions++;
+        entry = victim;
+    }
+    CanIdTableAccount(entry, time, payload_bytes, bus_bits);
+    return entry;
+}
+
+const CanIdStats *CanIdTableFind(const CanIdTable *self, uint32_t key) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    uint32_t index = CanHash(key, CAN_ID_TABLE_SIZE);
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ID_TABLE_MAX_PROBES; i++) {
+        const CanIdStats *entry = &self->entries[index];
+        if (entry->key == key) {
+            return entry;
+        }
+        if (entry->key == CAN_ID_TABLE_EMPTY) {
+            break;
+        }
+        index = (index + 1u) & (CAN_ID_TABLE_SIZE - 1u);
+    }
+    return NULL;
+}
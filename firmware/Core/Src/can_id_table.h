@@ -0,0 +1,55 @@
+/* Per identifier statistics in a fixed size hash table
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_ID_TABLE_H_
+#define CORE_SRC_CAN_ID_TABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* Key of an entry: the identifier, with this bit for extended frames */
+#define CAN_ID_TABLE_EXTENDED (0x80000000u)
+#define CAN_ID_TABLE_EMPTY (0xFFFFFFFFu)
+
+/* Statistics of one identifier, 40 bytes. Periods in CPU ticks, up to UINT32_MAX */
+typedef struct {
+    uint64_t last_time; /* 64-bit CPU ticks, the least recently received is found after DWT->CYCCNT wraps */
+    uint32_t key;
+    uint32_t frames;
+    uint32_t payload_bytes;
+    uint32_t bus_bits; /* Halved with bus_bits_total */
+    uint32_t min_period;
+    uint32_t max_period;
+    uint32_t mean_period; /* Exponential moving average */
+    uint32_t jitter;      /* Moving average of the period deviation from mean_period */
+} CanIdStats;
+
+/* Open addressing with linear probing. A new identifier that finds no empty slot within
+ * CAN_ID_TABLE_MAX_PROBES evicts one of the probed entries by CAN_ID_TABLE_EVICTION, so every operation is O(1).
+ * Entries are never deleted otherwise, so an empty slot ends a search. */
+typedef struct {
+    CanIdStats entries[CAN_ID_TABLE_SIZE];
+    uint32_t count;
+    uint32_t evictions;
+    uint32_t bus_bits_total; /* Of every frame, including the evicted identifiers. Halved at 2^31 with all entries */
+} CanIdTable;
+
+void CanIdTableInit(CanIdTable *self);
+
+static inline uint32_t CanIdTableMakeKey(uint32_t id, bool extended) {
+    return extended ? (id | CAN_ID_TABLE_EXTENDED) : id;
+}
+
+/* Account a frame, time in 64-bit CPU ticks. Returns the entry.
+ * Halving the bit counters is O(CAN_ID_TABLE_SIZE), once per 2^30 bits */
+CanIdStats *CanIdTableAdd(CanIdTable *self, uint32_t key, uint64_t time, uint32_t payload_bytes, uint32_t bus_bits);
+
+/* Returns NULL if the identifier is not in the table */
+const CanIdStats *CanIdTableFind(const CanIdTable *self, uint32_t key);
+
+#endif /* CORE_SRC_CAN_ID_TABLE_H_ */
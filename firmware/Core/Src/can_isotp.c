@@ -0,0 +1,363 @@
+/* ISO 15765-2 transfers between request and response identifiers
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_isotp.h"
+#include "can_id_table.h"
+#include <assert.h>
+#include <string.h>
+
+/* Protocol control information, the high nibble of the first byte */
+#define CAN_ISOTP_PCI_FIRST (1u)
+#define CAN_ISOTP_PCI_CONSECUTIVE (2u)
+#define CAN_ISOTP_PCI_FLOW_CONTROL (3u)
+
+/* Flow status */
+#define CAN_ISOTP_FS_CONTINUE (0u)
+#define CAN_ISOTP_FS_WAIT (1u)
+#define CAN_ISOTP_FS_OVERFLOW (2u)
+
+#define CAN_ISOTP_PCI_SINGLE (0u)
+#define CAN_ISOTP_FRAME_SIZE (8u)
+#define CAN_ISOTP_FF_PAYLOAD (6u)
+#define CAN_ISOTP_FF_ESCAPE_PAYLOAD (2u) /* Size above 4095 in 4 more bytes */
+#define CAN_ISOTP_NO_PEER (0xFFFFFFFFu)
+#define CAN_ISOTP_TESTER_FIRST (0xF1u) /* Source addresses of the external test equipment, ISO 15765-4 */
+#define CAN_ISOTP_TESTER_LAST (0xFDu)
+
+void CanIsoTpInit(CanIsoTp *self, uint32_t timeout, uint32_t pair_timeout) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+    self->timeout = timeout;
+    self->pair_timeout = pair_timeout;
+}
+
+/* The other identifier of the pair, CAN_ISOTP_NO_PEER if the identifier is not a diagnostic one */
+static uint32_t CanIsoTpGetPeer(uint32_t key) {
+    if ((key & CAN_ID_TABLE_EXTENDED) != 0u) {
+        const uint32_t format = (key >> 16u) & 0xFFu;
+        if ((format == 0xDAu) || (format == 0xDBu)) {
+            return (key & 0xFFFF0000u) | ((key & 0xFFu) << 8u) | ((key >> 8u) & 0xFFu);
+        }
+    } else if ((key >= 0x7E0u) && (key <= 0x7E7u)) {
+        return key + 8u;
+    } else if ((key >= 0x7E8u) && (key <= 0x7EFu)) {
+        return key - 8u;
+    } else {
+        /* Not diagnostic */
+    }
+    return CAN_ISOTP_NO_PEER;
+}
+
+static inline bool CanIsoTpIsTester(uint32_t address) {
+    return (address >= CAN_ISOTP_TESTER_FIRST) && (address <= CAN_ISOTP_TESTER_LAST);
+}
+
+/* Side of a diagnostic identifier: 7E0..7E7 and 29 bit from a tester address are requests, 7E8..7EF and 29 bit to
+ * a tester address are responses. Between two ECUs the identifier seen first is the request */
+static uint32_t CanIsoTpGetSide(uint32_t key) {
+    if ((key & CAN_ID_TABLE_EXTENDED) != 0u) {
+        if (!CanIsoTpIsTester(key & 0xFFu) && CanIsoTpIsTester((key >> 8u) & 0xFFu)) {
+            return CAN_ISOTP_RESPONSE;
+        }
+    } else if (key >= 0x7E8u) {
+        return CAN_ISOTP_RESPONSE;
+    } else {
+        /* 7E0..7E7 */
+    }
+    return CAN_ISOTP_REQUEST;
+}
+
+/* The pair of the identifier and its side, NULL if there is none */
+static CanIsoTpSession *CanIsoTpFindSession(CanIsoTp *self, uint32_t key, uint32_t *side) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ISOTP_SESSIONS; i++) {
+        CanIsoTpSession *session = &self->sessions[i];
+        if (session->state != (uint8_t)CAN_ISOTP_SESSION_FREE) {
+            if (session->key == key) {
+                *side = CAN_ISOTP_REQUEST;
+                return session;
+            }
+            if (session->peer == key) {
+                *side = CAN_ISOTP_RESPONSE;
+                return session;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* A new pair of the request and the response identifier. NULL if all sessions are busy */
+static CanIsoTpSession *CanIsoTpOpenSession(CanIsoTp *self, uint32_t key, uint32_t peer) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ISOTP_SESSIONS; i++) {
+        CanIsoTpSession *session = &self->sessions[i];
+        if (session->state == (uint8_t)CAN_ISOTP_SESSION_FREE) {
+            (void)memset(session, 0, sizeof(*session));
+            session->key = key;
+            session->peer = peer;
+            session->message_sender = (uint8_t)CAN_ISOTP_NOBODY;
+            session->state = (uint8_t)CAN_ISOTP_SESSION_IDLE;
+            return session;
+        }
+    }
+    self->session_overruns++;
+    return NULL;
+}
+
+static inline uint32_t CanIsoTpSaturate(uint64_t duration) {
+    return (duration < UINT32_MAX) ? (uint32_t)duration : UINT32_MAX;
+}
+
+/* A message of the side starts with the frame. The gap after a message of the other side is the ECU time before a
+ * response or the tester time before the next request */
+static void CanIsoTpStartMessage(CanIsoTpSession *session, uint32_t side, uint64_t time, uint32_t bus_time) {
+    const uint64_t start = time - bus_time;
+    if ((session->message_sender != (uint8_t)side) && (session->message_sender != (uint8_t)CAN_ISOTP_NOBODY) &&
+        (start > session->message_end)) {
+        const uint32_t gap = CanIsoTpSaturate(start - session->message_end);
+        if (side == CAN_ISOTP_RESPONSE) {
+            session->ecu_time = gap;
+        } else {
+            session->tester_time = gap;
+        }
+    }
+}
+
+static void CanIsoTpEndMessage(CanIsoTpSession *session, uint32_t side, uint64_t time) {
+    session->message_end = time;
+    session->message_sender = (uint8_t)side;
+}
+
+/* The pair stays open for the next message */
+static void CanIsoTpEndTransfer(CanIsoTp *self, CanIsoTpSession *session, bool complete) {
+    if (complete) {
+        CanIsoTpEndMessage(session, session->sender, session->last_time);
+        self->last = *session;
+        self->completed++;
+    } else {
+        self->aborts++;
+    }
+    session->state = (uint8_t)CAN_ISOTP_SESSION_IDLE;
+}
+
+/* A new message of either side abandons the transfer in progress */
+static void CanIsoTpAbandonTransfer(CanIsoTp *self, CanIsoTpSession *session) {
+    if (session->state != (uint8_t)CAN_ISOTP_SESSION_IDLE) {
+        CanIsoTpEndTransfer(self, session, false);
+    }
+}
+
+/* Finds or opens the pair of a single or a first frame */
+static CanIsoTpSession *CanIsoTpGetSession(CanIsoTp *self, uint32_t key, uint64_t time, uint32_t *side) {
+    CanIsoTpSession *session = CanIsoTpFindSession(self, key, side);
+    if (session == NULL) {
+        /* The device may attach in the middle of a dialogue, so the response may come first */
+        const uint32_t peer = CanIsoTpGetPeer(key);
+        if (peer != CAN_ISOTP_NO_PEER) {
+            *side = CanIsoTpGetSide(key);
+            session = (*side == CAN_ISOTP_REQUEST) ? CanIsoTpOpenSession(self, key, peer)
+                                                   : CanIsoTpOpenSession(self, peer, key);
+        }
+    }
+    if (session != NULL) {
+        session->pair_time = time;
+    }
+    return session;
+}
+
+static void CanIsoTpAddSingle(CanIsoTp *self, uint32_t key, const uint8_t data[], uint32_t size, uint64_t time,
+                              uint32_t bus_time) {
+    const uint32_t length = (uint32_t)data[0] & 0x0Fu;
+    if ((length == 0u) || (length >= size)) {
+        return; /* Not a single frame */
+    }
+    uint32_t side = CAN_ISOTP_REQUEST;
+    CanIsoTpSession *session = CanIsoTpGetSession(self, key, time, &side);
+    if (session == NULL) {
+        return;
+    }
+    CanIsoTpAbandonTransfer(self, session);
+    CanIsoTpStartMessage(session, side, time, bus_time);
+    CanIsoTpEndMessage(session, side, time);
+}
+
+static void CanIsoTpAddFirst(CanIsoTp *self, uint32_t key, const uint8_t data[], uint64_t time, uint32_t bus_time) {
+    uint32_t size = (((uint32_t)data[0] & 0x0Fu) << 8u) | data[1];
+    uint32_t payload = CAN_ISOTP_FF_PAYLOAD;
+    if (size == 0u) {
+        size = ((uint32_t)data[2] << 24u) | ((uint32_t)data[3] << 16u) | ((uint32_t)data[4] << 8u) | data[5];
+        payload = CAN_ISOTP_FF_ESCAPE_PAYLOAD;
+    }
+    if (size < CAN_ISOTP_FRAME_SIZE) {
+        return; /* Not a first frame, a single frame would do */
+    }
+    uint32_t side = CAN_ISOTP_REQUEST;
+    CanIsoTpSession *session = CanIsoTpGetSession(self, key, time, &side);
+    if (session == NULL) {
+        return;
+    }
+    CanIsoTpAbandonTransfer(self, session); /* Restarted */
+    CanIsoTpStartMessage(session, side, time, bus_time);
+
+    session->size = size;
+    session->received = payload;
+    session->start_time = time;
+    session->last_time = time;
+    session->wait_start = time;
+    session->fc_wait_time = 0u;
+    session->cf_time = 0u;
+    session->bus_time = bus_time;
+    session->next_sequence = 1u;
+    session->block_size = 0u;
+    session->block_left = 0u;
+    session->st_min = 0u;
+    session->sender = (uint8_t)side;
+    session->state = (uint8_t)CAN_ISOTP_SESSION_WAIT_FC;
+}
+
+static void CanIsoTpAddConsecutive(CanIsoTp *self, CanIsoTpSession *session, const uint8_t data[], uint32_t size,
+                                   uint64_t time, uint32_t bus_time) {
+    if ((session->state != (uint8_t)CAN_ISOTP_SESSION_SENDING) ||
+        (((uint32_t)data[0] & 0x0Fu) != session->next_sequence)) {
+        CanIsoTpEndTransfer(self, session, false);
+        return;
+    }
+    const uint32_t left = session->size - session->received;
+    session->received += ((size - 1u) < left) ? (size - 1u) : left;
+    session->next_sequence = (session->next_sequence + 1u) & 0x0Fu;
+    session->cf_time += (uint32_t)(time - session->last_time);
+    session->last_time = time;
+    session->bus_time += bus_time;
+    if (session->received >= session->size) {
+        CanIsoTpEndTransfer(self, session, true);
+    } else if (session->block_size != 0u) {
+        session->block_left--;
+        if (session->block_left == 0u) {
+            session->state = (uint8_t)CAN_ISOTP_SESSION_WAIT_FC;
+            session->wait_start = time;
+        }
+    } else {
+        /* No more flow control */
+    }
+}
+
+static void CanIsoTpAddFlowControl(CanIsoTp *self, CanIsoTpSession *session, const uint8_t data[], uint64_t time,
+                                   uint32_t bus_time) {
+    session->bus_time += bus_time;
+    switch ((uint32_t)data[0] & 0x0Fu) {
+        case CAN_ISOTP_FS_CONTINUE:
+            if (session->state == (uint8_t)CAN_ISOTP_SESSION_WAIT_FC) {
+                session->fc_wait_time += (uint32_t)(time - session->wait_start);
+                session->block_size = data[1];
+                session->block_left = data[1];
+                session->st_min = data[2];
+                session->state = (uint8_t)CAN_ISOTP_SESSION_SENDING;
+            }
+            session->last_time = time;
+            break;
+        case CAN_ISOTP_FS_WAIT:
+            session->last_time = time; /* The wait goes on */
+            break;
+        default:
+            CanIsoTpEndTransfer(self, session, false);
+            break;
+    }
+}
+
+void CanIsoTpAddFrame(CanIsoTp *self, uint32_t key, const uint8_t data[], uint32_t size, uint64_t time,
+                      uint32_t bus_time) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((size == 0u) || (data != NULL));
+
+    if (size == 0u) {
+        return;
+    }
+    const uint32_t pci = (uint32_t)data[0] >> 4u;
+    if (pci == CAN_ISOTP_PCI_SINGLE) {
+        CanIsoTpAddSingle(self, key, data, size, time, bus_time);
+        return;
+    }
+    if (pci == CAN_ISOTP_PCI_FIRST) {
+        if (size == CAN_ISOTP_FRAME_SIZE) {
+            CanIsoTpAddFirst(self, key, data, time, bus_time);
+        }
+        return;
+    }
+
+    /* The other frames belong to the transfer of a pair */
+    uint32_t side = CAN_ISOTP_REQUEST;
+    CanIsoTpSession *session = CanIsoTpFindSession(self, key, &side);
+    if (session == NULL) {
+        return;
+    }
+    session->pair_time = time;
+    if (session->state == (uint8_t)CAN_ISOTP_SESSION_IDLE) {
+        return;
+    }
+    const bool from_sender = session->sender == (uint8_t)side;
+    switch (pci) {
+        case CAN_ISOTP_PCI_CONSECUTIVE:
+            if (from_sender && (size >= 2u)) {
+                CanIsoTpAddConsecutive(self, session, data, size, time, bus_time);
+            }
+            break;
+        case CAN_ISOTP_PCI_FLOW_CONTROL:
+            if (!from_sender && (size >= 3u)) {
+                CanIsoTpAddFlowControl(self, session, data, time, bus_time);
+            }
+            break;
+        default:
+            /* Not ISO-TP */
+            break;
+    }
+}
+
+void CanIsoTpCheck(CanIsoTp *self, uint64_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ISOTP_SESSIONS; i++) {
+        CanIsoTpSession *session = &self->sessions[i];
+        if (session->state == (uint8_t)CAN_ISOTP_SESSION_IDLE) {
+            if ((int64_t)(now - session->pair_time) > (int64_t)self->pair_timeout) {
+                session->state = (uint8_t)CAN_ISOTP_SESSION_FREE;
+            }
+        } else if (session->state != (uint8_t)CAN_ISOTP_SESSION_FREE) {
+            if ((int64_t)(now - session->last_time) > (int64_t)self->timeout) {
+                CanIsoTpEndTransfer(self, session, false);
+            }
+        } else {
+            /* Free */
+        }
+    }
+}
+
+const CanIsoTpSession *CanIsoTpGetActive(const CanIsoTp *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    const CanIsoTpSession *active = NULL;
+    const CanIsoTpSession *latest = NULL;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_ISOTP_SESSIONS; i++) {
+        const CanIsoTpSession *session = &self->sessions[i];
+        if (session->state == (uint8_t)CAN_ISOTP_SESSION_FREE) {
+            continue;
+        }
+        if ((session->state != (uint8_t)CAN_ISOTP_SESSION_IDLE) &&
+            ((active == NULL) || (session->received > active->received))) {
+            active = session;
+        }
+        if ((latest == NULL) || (session->pair_time > latest->pair_time)) {
+            latest = session;
+        }
+    }
+    return (active != NULL) ? active : latest;
+}
@@ -0,0 +1,78 @@
+/* ISO 15765-2 transfers between request and response identifiers
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_ISOTP_H_
+#define CORE_SRC_CAN_ISOTP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+typedef enum {
+    CAN_ISOTP_SESSION_FREE,
+    CAN_ISOTP_SESSION_IDLE,     /* No transfer, single frames and the gaps between the messages are tracked */
+    CAN_ISOTP_SESSION_WAIT_FC,  /* After the first frame or a block, until the flow control allows to send */
+    CAN_ISOTP_SESSION_SENDING   /* Consecutive frames */
+} CanIsoTpSessionState;
+
+/* Sides of a pair */
+#define CAN_ISOTP_REQUEST (0u)
+#define CAN_ISOTP_RESPONSE (1u)
+#define CAN_ISOTP_NOBODY (2u)
+
+/* A request and a response identifier with the multi-frame transfer of either side in progress, 88 bytes.
+ * Only the bytes and the sequence numbers are counted, the payload is not stored. Times in 64-bit CPU ticks,
+ * durations in CPU ticks */
+typedef struct {
+    uint64_t start_time;  /* First frame of the transfer */
+    uint64_t last_time;   /* Last frame of the transfer */
+    uint64_t wait_start;
+    uint64_t pair_time;   /* Last frame of the pair */
+    uint64_t message_end; /* Last frame of the last complete message */
+    uint32_t key;  /* Request identifier, of the tester. CAN_ID_TABLE_EXTENDED for 29 bit */
+    uint32_t peer; /* Response identifier */
+    uint32_t size; /* Transfer bytes from the first frame */
+    uint32_t received;
+    uint32_t fc_wait_time; /* Sender waiting for the flow control: block size and receiver delays */
+    uint32_t cf_time;      /* From the previous frame to each consecutive frame: STmin and sender delays */
+    uint32_t bus_time;     /* Frames of the transfer on the wire */
+    uint32_t ecu_time;     /* From the end of a request to the start of its response */
+    uint32_t tester_time;  /* From the end of a response to the start of the next request */
+    uint8_t next_sequence;
+    uint8_t block_size; /* From the last flow control, 0 = no more flow control */
+    uint8_t block_left;
+    uint8_t st_min;         /* Raw, 0..127 ms or F1..F9 100..900 us */
+    uint8_t state;          /* CanIsoTpSessionState */
+    uint8_t sender;         /* Of the transfer, CAN_ISOTP_REQUEST or CAN_ISOTP_RESPONSE */
+    uint8_t message_sender; /* Of the last complete message, CAN_ISOTP_NOBODY before it */
+} CanIsoTpSession;
+
+/* A fixed pool of pairs. The peer of an identifier is found by the usual addressing: 7E0..7E7 to 7E8..7EF
+ * and 29 bit normal fixed 18DA/18DB with the target and source addresses swapped. Other identifiers are ignored */
+typedef struct {
+    uint32_t timeout;      /* N_Bs and N_Cr, CPU ticks */
+    uint32_t pair_timeout; /* CPU ticks without a frame that close a pair */
+    CanIsoTpSession sessions[CAN_ISOTP_SESSIONS];
+    CanIsoTpSession last; /* At the end of the last completed transfer */
+    uint32_t completed;
+    uint32_t aborts;           /* Wrong sequence number, overflow, timeout or a new message */
+    uint32_t session_overruns; /* Pairs not tracked, all sessions were busy */
+} CanIsoTp;
+
+void CanIsoTpInit(CanIsoTp *self, uint32_t timeout, uint32_t pair_timeout);
+
+/* Key as CanIdTableMakeKey, time in 64-bit CPU ticks, bus time of the frame in CPU ticks. O(CAN_ISOTP_SESSIONS) */
+void CanIsoTpAddFrame(CanIsoTp *self, uint32_t key, const uint8_t data[], uint32_t size, uint64_t time,
+                      uint32_t bus_time);
+
+/* Abort the transfers without frames for the timeout, close the pairs without frames for the pair timeout */
+void CanIsoTpCheck(CanIsoTp *self, uint64_t now);
+
+/* The pair with a transfer in progress and the most bytes, else the pair with the latest frame. NULL if none */
+const CanIsoTpSession *CanIsoTpGetActive(const CanIsoTp *self);
+
+#endif /* CORE_SRC_CAN_ISOTP_H_ */
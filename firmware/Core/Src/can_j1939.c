@@ -0,0 +1,265 @@
+/* J1939 statistics by PGN and source address, transport protocol sessions
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_j1939.h"
+#include "can_hash.h"
+#include <assert.h>
+#include <string.h>
+
+#if ((CAN_J1939_PGN_TABLE_SIZE & (CAN_J1939_PGN_TABLE_SIZE - 1u)) != 0u) || \
+    ((CAN_J1939_SOURCE_TABLE_SIZE & (CAN_J1939_SOURCE_TABLE_SIZE - 1u)) != 0u)
+#error The J1939 table sizes must be powers of two
+#endif
+
+/* TP.CM control bytes */
+#define CAN_J1939_TP_RTS (16u)
+#define CAN_J1939_TP_CTS (17u)
+#define CAN_J1939_TP_EOMA (19u) /* End of message acknowledge */
+#define CAN_J1939_TP_BAM (32u)
+#define CAN_J1939_TP_ABORT (255u)
+
+#define CAN_J1939_TP_FRAME_SIZE (8u)
+#define CAN_J1939_BITS_LIMIT (0x80000000u)
+
+void CanJ1939Init(CanJ1939 *self, uint32_t timeout) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+    self->timeout = timeout;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_J1939_PGN_TABLE_SIZE; i++) {
+        self->pgns[i].key = CAN_J1939_EMPTY;
+    }
+    for (i = 0u; i < CAN_J1939_SOURCE_TABLE_SIZE; i++) {
+        self->sources[i].key = CAN_J1939_EMPTY;
+    }
+}
+
+/* Open addressing, the whole table is probed. Returns false if the key does not fit */
+static bool CanJ1939Count(CanJ1939Counter counters[], uint32_t size, uint32_t key, uint32_t frames, uint32_t bits) {
+    uint32_t index = CanHash(key, size);
+    uint32_t i = 0u;
+    for (i = 0u; i < size; i++) {
+        CanJ1939Counter *counter = &counters[index & (size - 1u)];
+        if (counter->key == CAN_J1939_EMPTY) {
+            counter->key = key;
+        }
+        if (counter->key == key) {
+            counter->frames += frames;
+            counter->bus_bits += bits;
+            return true;
+        }
+        index++;
+    }
+    return false;
+}
+
+static void CanJ1939CountPgn(CanJ1939 *self, uint32_t pgn, uint32_t frames, uint32_t bits) {
+    if (!CanJ1939Count(self->pgns, CAN_J1939_PGN_TABLE_SIZE, pgn, frames, bits)) {
+        self->other_pgn_bits += bits;
+    }
+}
+
+/* Keeps the shares of the bus time, older traffic weighs less */
+static void CanJ1939HalveBits(CanJ1939 *self) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_J1939_PGN_TABLE_SIZE; i++) {
+        self->pgns[i].bus_bits /= 2u;
+    }
+    for (i = 0u; i < CAN_J1939_SOURCE_TABLE_SIZE; i++) {
+        self->sources[i].bus_bits /= 2u;
+    }
+    self->other_pgn_bits /= 2u;
+    self->other_source_bits /= 2u;
+    self->bus_bits_total /= 2u;
+}
+
+static CanJ1939Session *CanJ1939FindSession(CanJ1939 *self, uint32_t source, uint32_t destination) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_J1939_SESSIONS; i++) {
+        CanJ1939Session *session = &self->sessions[i];
+        if ((session->state != (uint8_t)CAN_J1939_SESSION_FREE) && (session->source == source) &&
+            (session->destination == destination)) {
+            return session;
+        }
+    }
+    return NULL;
+}
+
+static CanJ1939Session *CanJ1939AllocateSession(CanJ1939 *self) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_J1939_SESSIONS; i++) {
+        if (self->sessions[i].state == (uint8_t)CAN_J1939_SESSION_FREE) {
+            return &self->sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/* The transfer is one logical message of the transported PGN, an aborted one only adds its bits */
+static void CanJ1939EndSession(CanJ1939 *self, CanJ1939Session *session, bool complete, uint64_t time) {
+    CanJ1939CountPgn(self, session->pgn, complete ? 1u : 0u, session->bus_bits);
+    if (complete) {
+        self->messages++;
+        self->last_pgn = session->pgn;
+        self->last_size = session->size;
+        self->last_duration = time - session->start_time;
+    } else {
+        self->aborts++;
+    }
+    session->state = (uint8_t)CAN_J1939_SESSION_FREE;
+}
+
+static void CanJ1939AddToSession(CanJ1939Session *session, uint64_t time, uint32_t bits) {
+    session->last_time = time;
+    session->bus_bits += bits;
+}
+
+/* Returns true if the frame belongs to a session */
+static bool CanJ1939AddControl(CanJ1939 *self, uint32_t source, uint32_t destination, const uint8_t data[],
+                               uint64_t time, uint32_t bits) {
+    CanJ1939Session *session = NULL;
+    switch (data[0]) {
+        case CAN_J1939_TP_BAM:
+        case CAN_J1939_TP_RTS:
+            session = CanJ1939FindSession(self, source, destination);
+            if (session != NULL) {
+                CanJ1939EndSession(self, session, false, time); /* Restarted */
+            } else {
+                session = CanJ1939AllocateSession(self);
+            }
+            if (session == NULL) {
+                self->session_overruns++;
+                return false;
+            }
+            session->pgn = (uint32_t)data[5] | ((uint32_t)data[6] << 8u) | ((uint32_t)data[7] << 16u);
+            session->size = (uint16_t)((uint32_t)data[1] | ((uint32_t)data[2] << 8u));
+            session->source = (uint8_t)source;
+            session->destination = (uint8_t)destination;
+            session->packets = data[3];
+            session->next_sequence = 1u;
+            session->start_time = time;
+            session->bus_bits = 0u;
+            session->state =
+                (uint8_t)((data[0] == CAN_J1939_TP_BAM) ? CAN_J1939_SESSION_BAM : CAN_J1939_SESSION_CMDT);
+            CanJ1939AddToSession(session, time, bits);
+            return true;
+        case CAN_J1939_TP_CTS:
+            /* From the receiver, the next packet to send */
+            session = CanJ1939FindSession(self, destination, source);
+            if (session == NULL) {
+                return false;
+            }
+            if (data[2] != 0u) {
+                session->next_sequence = data[2];
+            }
+            CanJ1939AddToSession(session, time, bits);
+            return true;
+        case CAN_J1939_TP_EOMA:
+            session = CanJ1939FindSession(self, destination, source);
+            if (session == NULL) {
+                return false;
+            }
+            CanJ1939AddToSession(session, time, bits);
+            CanJ1939EndSession(self, session, true, time);
+            return true;
+        case CAN_J1939_TP_ABORT:
+            session = CanJ1939FindSession(self, source, destination);
+            if (session == NULL) {
+                session = CanJ1939FindSession(self, destination, source);
+            }
+            if (session == NULL) {
+                return false;
+            }
+            CanJ1939AddToSession(session, time, bits);
+            CanJ1939EndSession(self, session, false, time);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Returns true if the frame belongs to a session */
+static bool CanJ1939AddData(CanJ1939 *self, uint32_t source, uint32_t destination, const uint8_t data[],
+                            uint64_t time, uint32_t bits) {
+    CanJ1939Session *session = CanJ1939FindSession(self, source, destination);
+    if (session == NULL) {
+        return false;
+    }
+    CanJ1939AddToSession(session, time, bits);
+    const uint32_t sequence = data[0];
+    if ((sequence != session->next_sequence) || (sequence > session->packets)) {
+        CanJ1939EndSession(self, session, false, time); /* Lost packet */
+        return true;
+    }
+    session->next_sequence++;
+    if ((session->state == (uint8_t)CAN_J1939_SESSION_BAM) && (sequence == session->packets)) {
+        CanJ1939EndSession(self, session, true, time);
+    }
+    return true;
+}
+
+void CanJ1939AddFrame(CanJ1939 *self, uint32_t id, const uint8_t data[], uint32_t size, uint64_t time,
+                      uint32_t bits) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((size == 0u) || (data != NULL));
+
+    if ((self->bus_bits_total + bits) >= CAN_J1939_BITS_LIMIT) {
+        CanJ1939HalveBits(self);
+    }
+    self->bus_bits_total += bits;
+
+    const uint32_t source = CanJ1939GetSource(id);
+    if (!CanJ1939Count(self->sources, CAN_J1939_SOURCE_TABLE_SIZE, source, 1u, bits)) {
+        self->other_source_bits += bits;
+    }
+
+    const uint32_t pgn = CanJ1939GetPgn(id);
+    const uint32_t destination = CanJ1939GetDestination(id);
+    bool in_session = false;
+    if (size == CAN_J1939_TP_FRAME_SIZE) {
+        if (pgn == CAN_J1939_PGN_TP_CM) {
+            in_session = CanJ1939AddControl(self, source, destination, data, time, bits);
+        } else if (pgn == CAN_J1939_PGN_TP_DT) {
+            in_session = CanJ1939AddData(self, source, destination, data, time, bits);
+        } else {
+            /* Single frame */
+        }
+    }
+    if (!in_session) {
+        CanJ1939CountPgn(self, pgn, 1u, bits);
+    }
+}
+
+void CanJ1939Check(CanJ1939 *self, uint64_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_J1939_SESSIONS; i++) {
+        CanJ1939Session *session = &self->sessions[i];
+        if ((session->state != (uint8_t)CAN_J1939_SESSION_FREE) &&
+            ((int64_t)(now - session->last_time) > (int64_t)self->timeout)) {
+            CanJ1939EndSession(self, session, false, now);
+        }
+    }
+}
+
+const CanJ1939Counter *CanJ1939GetTop(const CanJ1939Counter counters[], size_t count) {
+    /* Check parameters */
+    assert(counters != NULL);
+
+    const CanJ1939Counter *top = NULL;
+    size_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        if ((counters[i].key != CAN_J1939_EMPTY) && ((top == NULL) || (counters[i].bus_bits > top->bus_bits))) {
+            top = &counters[i];
+        }
+    }
+    return top;
+}
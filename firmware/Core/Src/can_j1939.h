@@ -0,0 +1,100 @@
+/* J1939 statistics by PGN and source address, transport protocol sessions
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_J1939_H_
+#define CORE_SRC_CAN_J1939_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+#define CAN_J1939_PGN_TP_CM (0xEC00u)
+#define CAN_J1939_PGN_TP_DT (0xEB00u)
+#define CAN_J1939_GLOBAL_ADDRESS (0xFFu)
+#define CAN_J1939_PDU2_PF (240u) /* PF of the PDU2 format, PS is a group extension instead of a destination */
+
+/* 29 bit identifier fields */
+static inline uint32_t CanJ1939GetPriority(uint32_t id) {
+    return (id >> 26u) & 0x07u;
+}
+
+static inline uint32_t CanJ1939GetPgn(uint32_t id) {
+    const uint32_t pf = (id >> 16u) & 0xFFu;
+    const uint32_t pgn = (id >> 8u) & 0x3FFFFu; /* EDP, DP, PF, PS */
+    return (pf < CAN_J1939_PDU2_PF) ? (pgn & 0x3FF00u) : pgn;
+}
+
+static inline uint32_t CanJ1939GetDestination(uint32_t id) {
+    const uint32_t pf = (id >> 16u) & 0xFFu;
+    return (pf < CAN_J1939_PDU2_PF) ? ((id >> 8u) & 0xFFu) : CAN_J1939_GLOBAL_ADDRESS;
+}
+
+static inline uint32_t CanJ1939GetSource(uint32_t id) {
+    return id & 0xFFu;
+}
+
+#define CAN_J1939_EMPTY (0xFFFFFFFFu)
+
+/* Frames and bus bits of a PGN or a source address */
+typedef struct {
+    uint32_t key;
+    uint32_t frames; /* Logical messages for the PGNs, a transport session is one */
+    uint32_t bus_bits;
+} CanJ1939Counter;
+
+typedef enum {
+    CAN_J1939_SESSION_FREE,
+    CAN_J1939_SESSION_BAM, /* Broadcast announce, packets every 50..200 ms */
+    CAN_J1939_SESSION_CMDT /* Connection mode with RTS/CTS flow control */
+} CanJ1939SessionState;
+
+/* Transfer from source to destination, times in 64-bit CPU ticks */
+typedef struct {
+    uint64_t start_time;
+    uint64_t last_time;
+    uint32_t pgn;      /* Transported */
+    uint32_t bus_bits; /* TP.CM and TP.DT frames of the transfer */
+    uint16_t size;     /* Bytes */
+    uint8_t source;
+    uint8_t destination;
+    uint8_t packets;
+    uint8_t next_sequence;
+    uint8_t state; /* CanJ1939SessionState */
+} CanJ1939Session;
+
+/* Every frame is counted by its source address. A frame is counted by its PGN, except the TP.CM and TP.DT frames of
+ * a session, which are counted by the transported PGN when the session ends. Tables are fixed, a key that does not
+ * fit is counted in the others */
+typedef struct {
+    uint32_t timeout; /* CPU ticks without a packet that abort a session */
+    CanJ1939Counter pgns[CAN_J1939_PGN_TABLE_SIZE];
+    CanJ1939Counter sources[CAN_J1939_SOURCE_TABLE_SIZE];
+    uint32_t other_pgn_bits;
+    uint32_t other_source_bits;
+    uint32_t bus_bits_total; /* Halved at 2^31 with all counters */
+    CanJ1939Session sessions[CAN_J1939_SESSIONS];
+    uint32_t messages;         /* Completed transfers */
+    uint32_t aborts;           /* Aborted, timed out or lost packets */
+    uint32_t session_overruns; /* Transfers not tracked, all sessions were busy */
+    uint32_t last_pgn;         /* Last completed transfer */
+    uint32_t last_size;
+    uint64_t last_duration; /* CPU ticks */
+} CanJ1939;
+
+void CanJ1939Init(CanJ1939 *self, uint32_t timeout);
+
+/* Extended frame, time in 64-bit CPU ticks, bits on the wire. O(CAN_J1939_SESSIONS) */
+void CanJ1939AddFrame(CanJ1939 *self, uint32_t id, const uint8_t data[], uint32_t size, uint64_t time,
+                      uint32_t bits);
+
+/* Abort the sessions without packets for the timeout */
+void CanJ1939Check(CanJ1939 *self, uint64_t now);
+
+/* The counter with the most bus bits, NULL if the table is empty */
+const CanJ1939Counter *CanJ1939GetTop(const CanJ1939Counter counters[], size_t count);
+
+#endif /* CORE_SRC_CAN_J1939_H_ */
@@ -0,0 +1,73 @@
+/* CAN bus load calculation from falling edge timestamps
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_load.h"
+#include <assert.h>
+
+void CanLoadInit(CanLoad *self, uint32_t payload_time) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->payload_time = payload_time;
+    self->prev_time = 0u;
+    self->prev_time_valid = false;
+    self->edges = 0u;
+    self->active_time = 0u;
+    self->inactive_time = 0u;
+}
+
+void CanLoadResync(CanLoad *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->prev_time_valid = false;
+}
+
+void CanLoadSetPayloadTime(CanLoad *self, uint32_t payload_time) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->payload_time = payload_time;
+    self->prev_time_valid = false;
+}
+
+void CanLoadAddEdges(CanLoad *self, const CanEdge edges[], size_t count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((edges != NULL) || (count == 0u));
+
+    /* Local copies let the compiler keep everything in registers */
+    const uint32_t payload_time = self->payload_time;
+    uint32_t prev_time = self->prev_time;
+    bool prev_time_valid = self->prev_time_valid;
+    uint32_t falling_edges = self->edges;
+    uint32_t active_time = self->active_time;
+    uint32_t inactive_time = self->inactive_time;
+    size_t i = 0u;
+    for (i = 0u; i < count; i++) {
+        const CanEdge edge = edges[i];
+        if (CanEdgeIsRising(edge) == false) {
+            const uint32_t time = CanEdgeTime(edge);
+            if (prev_time_valid) {
+                const uint32_t period = time - prev_time;
+                if (period < payload_time) {
+                    active_time += period;
+                } else {
+                    inactive_time += period - payload_time;
+                    active_time += payload_time;
+                }
+            }
+            prev_time = time;
+            prev_time_valid = true;
+            falling_edges++;
+        }
+    }
+    self->prev_time = prev_time;
+    self->prev_time_valid = prev_time_valid;
+    self->edges = falling_edges;
+    self->active_time = active_time;
+    self->inactive_time = inactive_time;
+}
@@ -0,0 +1,56 @@
+/* CAN bus load calculation from falling edge timestamps
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_LOAD_H_
+#define CORE_SRC_CAN_LOAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_edge.h"
+
+/* The bus is counted as active between two falling edges closer than payload_time.
+ * After a longer gap only payload_time is counted as active, the rest is idle. */
+typedef struct {
+    uint32_t payload_time;
+    uint32_t prev_time;
+    bool prev_time_valid;
+    uint32_t edges; /* Falling */
+    uint32_t active_time;
+    uint32_t inactive_time;
+} CanLoad;
+
+void CanLoadInit(CanLoad *self, uint32_t payload_time);
+
+/* Forget the previous edge, e.g. after lost edges */
+void CanLoadResync(CanLoad *self);
+
+/* Change the bit rate at runtime */
+void CanLoadSetPayloadTime(CanLoad *self, uint32_t payload_time);
+
+static inline void CanLoadAddPeriod(CanLoad *self, uint32_t period) {
+    if (period < self->payload_time) {
+        self->active_time += period;
+    } else {
+        self->inactive_time += period - self->payload_time;
+        self->active_time += self->payload_time;
+    }
+}
+
+/* Single edge, CPU ticks. Used from the interrupt handler */
+static inline void CanLoadAddEdge(CanLoad *self, uint32_t time) {
+    if (self->prev_time_valid) {
+        CanLoadAddPeriod(self, time - self->prev_time);
+    }
+    self->prev_time = time;
+    self->prev_time_valid = true;
+    self->edges++;
+}
+
+/* Batch of edges in time order, rising edges are skipped */
+void CanLoadAddEdges(CanLoad *self, const CanEdge edges[], size_t count);
+
+#endif /* CORE_SRC_CAN_LOAD_H_ */
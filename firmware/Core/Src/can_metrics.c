@@ -0,0 +1,30 @@
+/* Consistent snapshots of counters published from interrupts and the main loop
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_metrics.h"
+#include <assert.h>
+#include <string.h>
+
+void CanMetricsInit(CanMetrics *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+void CanMetricsRead(const CanMetrics *self, CanMetricsData *result) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(result != NULL);
+
+    uint32_t sequence = 0u;
+    do {
+        sequence = self->sequence;
+        CAN_METRICS_BARRIER();
+        (void)memcpy(result, &self->data, sizeof(*result));
+        CAN_METRICS_BARRIER();
+    } while (((sequence & 1u) != 0u) || (sequence != self->sequence));
+}
@@ -0,0 +1,92 @@
+/* Consistent snapshots of counters published from interrupts and the main loop
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_METRICS_H_
+#define CORE_SRC_CAN_METRICS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Free running counters, consumers calculate deltas */
+typedef struct {
+    /* Falling edges */
+    uint32_t edges;
+    uint32_t glitches; /* Rejected pulses */
+    uint32_t active_time;   /* CPU ticks */
+    uint32_t inactive_time; /* CPU ticks */
+
+    /* EXTI storm protection */
+    uint32_t sampling_coverage; /* Percent of time the edges are seen, 100 = full rate */
+
+    /* Input capture */
+    uint32_t capture_overruns;
+
+    /* Decoded frames */
+    uint32_t frames;
+    uint32_t busy_time; /* CPU ticks */
+    uint32_t stuff_errors;
+    uint32_t form_errors;
+    uint32_t crc_errors;
+    uint32_t bursts;           /* Back-to-back frame trains */
+    uint32_t max_burst_length; /* Frames */
+    uint32_t decoder_cycles;   /* CPU ticks in the decoder, divide by the bits of busy_time */
+    uint32_t wanted_frames;    /* Without a CRC error and in CAN_FILTER_WANTED, for CAN_FILTER_FOCUS */
+
+    /* Received by bxCAN */
+    uint32_t rx_read_frames;   /* Read from the FIFOs in the interrupt */
+    uint32_t rx_read_cycles;   /* CPU ticks in the interrupt, divide by rx_read_frames */
+    uint32_t rx_frames;        /* Processed in the main loop */
+    uint32_t rx_busy_time;     /* Exact lengths of the processed frames, CPU ticks */
+    uint32_t rx_wanted_frames; /* Processed and in CAN_FILTER_WANTED, for CAN_FILTER_FOCUS */
+    uint32_t rx_overruns;      /* Dropped, the frame ring was full */
+    uint32_t rx_fifo_overruns; /* bxCAN FIFO overruns, at least one frame lost each */
+    uint32_t rx_high_water;    /* Max frames waiting in the ring */
+    uint32_t rx_ids;           /* Identifiers in the table */
+    uint32_t rx_id_evictions;  /* Identifiers replaced in the full table */
+
+    /* Periodic identifiers */
+    uint32_t schedule_early;
+    uint32_t schedule_late;
+    uint32_t schedule_missing;
+
+    /* Errors */
+    uint32_t error_frames;
+    uint32_t error_time; /* CPU ticks */
+    uint32_t bus_errors; /* Last error code changes seen by bxCAN */
+    uint8_t tec;
+    uint8_t rec;
+    uint8_t error_state; /* CAN_STATUS_WARNING, ... */
+} CanMetricsData;
+
+/* Sequence lock. The sequence is odd while a producer writes. Interrupts are not disabled.
+ * Consumers run in the main loop, so a producer in the main loop can't be interrupted by a consumer,
+ * and a producer in an interrupt always finishes before the consumer continues. Each field has one producer. */
+typedef struct {
+    volatile uint32_t sequence;
+    CanMetricsData data;
+} CanMetrics;
+
+/* Single core: only the compiler may reorder the stores */
+#define CAN_METRICS_BARRIER() __asm__ volatile("" ::: "memory")
+
+void CanMetricsInit(CanMetrics *self);
+
+/* Returns the data to fill, the write ends with CanMetricsEndWrite */
+static inline CanMetricsData *CanMetricsBeginWrite(CanMetrics *self) {
+    self->sequence++;
+    CAN_METRICS_BARRIER();
+    return &self->data;
+}
+
+static inline void CanMetricsEndWrite(CanMetrics *self) {
+    CAN_METRICS_BARRIER();
+    self->sequence++;
+}
+
+/* Copy all counters as of one moment */
+void CanMetricsRead(const CanMetrics *self, CanMetricsData *result);
+
+#endif /* CORE_SRC_CAN_METRICS_H_ */
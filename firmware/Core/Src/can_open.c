@@ -0,0 +1,156 @@
+/* CANopen traffic classes and node states
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_open.h"
+#include <assert.h>
+#include <string.h>
+
+#define CAN_OPEN_IDS_COUNT (2048u)
+#define CAN_OPEN_BITS_LIMIT (0x80000000u)
+#define CAN_OPEN_PERIOD_SHIFT (2u) /* The period follows 1/4 of every change */
+
+/* Two 4 bit classes per byte, the even identifier in the low nibble */
+#define CAN_OPEN_PAIR(a, b) ((uint8_t)((uint32_t)(a) | ((uint32_t)(b) << 4u)))
+#define CAN_OPEN_8(c) CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c)
+#define CAN_OPEN_32(c) CAN_OPEN_8(c), CAN_OPEN_8(c), CAN_OPEN_8(c), CAN_OPEN_8(c)
+
+/* A function code is 128 identifiers */
+#define CAN_OPEN_ROW(c) CAN_OPEN_32(c), CAN_OPEN_32(c), CAN_OPEN_32(c), CAN_OPEN_32(c)
+
+/* Node 0 of the function code is another class */
+#define CAN_OPEN_ROW_NODE_0(first, c)                                                                       \
+    CAN_OPEN_PAIR(first, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_8(c), \
+        CAN_OPEN_8(c), CAN_OPEN_8(c), CAN_OPEN_32(c), CAN_OPEN_32(c), CAN_OPEN_32(c)
+
+/* 7E4 and 7E5 are LSS */
+#define CAN_OPEN_ROW_LSS(c)                                                                                      \
+    CAN_OPEN_32(c), CAN_OPEN_32(c), CAN_OPEN_32(c), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c),                    \
+        CAN_OPEN_PAIR(CAN_OPEN_LSS, CAN_OPEN_LSS), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), \
+        CAN_OPEN_PAIR(c, c), CAN_OPEN_PAIR(c, c), CAN_OPEN_8(c), CAN_OPEN_8(c)
+
+static const uint8_t can_open_classes[CAN_OPEN_IDS_COUNT / 2u] = {
+    CAN_OPEN_ROW_NODE_0(CAN_OPEN_NMT, CAN_OPEN_OTHER),   /* 000 */
+    CAN_OPEN_ROW_NODE_0(CAN_OPEN_SYNC, CAN_OPEN_EMCY),   /* 080 */
+    CAN_OPEN_ROW_NODE_0(CAN_OPEN_TIME, CAN_OPEN_OTHER),  /* 100 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 180 TPDO1 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 200 RPDO1 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 280 TPDO2 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 300 RPDO2 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 380 TPDO3 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 400 RPDO3 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 480 TPDO4 */
+    CAN_OPEN_ROW(CAN_OPEN_PDO),                          /* 500 RPDO4 */
+    CAN_OPEN_ROW(CAN_OPEN_SDO),                          /* 580 SDO server to client */
+    CAN_OPEN_ROW(CAN_OPEN_SDO),                          /* 600 SDO client to server */
+    CAN_OPEN_ROW(CAN_OPEN_OTHER),                        /* 680 */
+    CAN_OPEN_ROW(CAN_OPEN_HEARTBEAT),                    /* 700 */
+    CAN_OPEN_ROW_LSS(CAN_OPEN_OTHER),                    /* 780 */
+};
+
+CanOpenClass CanOpenGetClass(uint32_t id) {
+    /* Check parameters */
+    assert(id < CAN_OPEN_IDS_COUNT);
+
+    return (CanOpenClass)((can_open_classes[id / 2u] >> ((id % 2u) * 4u)) & 0x0Fu);
+}
+
+void CanOpenInit(CanOpen *self, uint32_t ticks_per_ms) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(ticks_per_ms > 0u);
+
+    (void)memset(self, 0, sizeof(*self));
+    self->ticks_per_ms = ticks_per_ms;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_OPEN_NODES_COUNT; i++) {
+        self->nodes[i].state = CAN_OPEN_STATE_UNKNOWN;
+    }
+}
+
+/* Keeps the shares of the bus time, older traffic weighs less */
+static void CanOpenHalveBits(CanOpen *self) {
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_OPEN_CLASSES_COUNT; i++) {
+        self->bus_bits[i] /= 2u;
+    }
+    self->bus_bits_total /= 2u;
+}
+
+/* Heartbeats are compared in ms, so the ages fit 32 bits for 49 days */
+static inline uint32_t CanOpenGetMs(const CanOpen *self, uint64_t time) {
+    return (uint32_t)(time / self->ticks_per_ms);
+}
+
+static void CanOpenAddHeartbeat(CanOpen *self, uint32_t node_id, uint8_t state, uint64_t time) {
+    CanOpenNode *node = &self->nodes[node_id - 1u];
+    const uint32_t time_ms = CanOpenGetMs(self, time);
+    if ((node->state != CAN_OPEN_STATE_UNKNOWN) && (state != CAN_OPEN_STATE_BOOT_UP)) {
+        const uint32_t interval = time_ms - node->last_ms;
+        if ((node->flags & CAN_OPEN_NODE_PERIOD_VALID) == 0u) {
+            if (interval <= UINT16_MAX) {
+                node->period = (uint16_t)interval;
+                node->flags |= CAN_OPEN_NODE_PERIOD_VALID;
+            }
+        } else if (interval < (((uint32_t)node->period * 3u) / 2u)) {
+            const int32_t change = (int32_t)interval - (int32_t)node->period;
+            node->period = (uint16_t)((int32_t)node->period + (change / (1 << CAN_OPEN_PERIOD_SHIFT)));
+        } else {
+            /* A heartbeat has been missed */
+        }
+    }
+    node->state = state;
+    node->last_ms = time_ms;
+    node->flags &= (uint8_t)~CAN_OPEN_NODE_LOST;
+}
+
+void CanOpenAddFrame(CanOpen *self, uint32_t id, const uint8_t data[], uint32_t size, uint64_t time, uint32_t bits) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert((size == 0u) || (data != NULL));
+
+    if ((self->bus_bits_total + bits) >= CAN_OPEN_BITS_LIMIT) {
+        CanOpenHalveBits(self);
+    }
+    self->bus_bits_total += bits;
+
+    const CanOpenClass cls = CanOpenGetClass(id);
+    self->bus_bits[cls] += bits;
+    if (cls == CAN_OPEN_NMT) {
+        self->nmt_commands++;
+    } else if ((cls == CAN_OPEN_HEARTBEAT) && (size >= 1u) && (CanOpenGetNode(id) != 0u)) {
+        CanOpenAddHeartbeat(self, CanOpenGetNode(id), data[0] & 0x7Fu, time);
+    } else {
+        /* Counted by class only */
+    }
+}
+
+uint32_t CanOpenCheck(CanOpen *self, uint64_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    const uint32_t now_ms = CanOpenGetMs(self, now);
+    uint32_t first_lost = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_OPEN_NODES_COUNT; i++) {
+        CanOpenNode *node = &self->nodes[i];
+        if ((node->flags & CAN_OPEN_NODE_PERIOD_VALID) == 0u) {
+            continue;
+        }
+        /* Up to 98 s for the longest period, clamped below the wrap of the age */
+        const uint64_t deadline64 = ((uint64_t)node->period * CAN_OPEN_HEARTBEAT_MISSING_PERCENT) / 100u;
+        const uint32_t deadline = (deadline64 < INT32_MAX) ? (uint32_t)deadline64 : (uint32_t)INT32_MAX;
+        if (((node->flags & CAN_OPEN_NODE_LOST) != 0u) || ((now_ms - node->last_ms) > deadline)) {
+            if ((node->flags & CAN_OPEN_NODE_LOST) == 0u) {
+                node->flags |= CAN_OPEN_NODE_LOST;
+                self->heartbeat_misses++;
+            }
+            if (first_lost == 0u) {
+                first_lost = i + 1u;
+            }
+        }
+    }
+    return first_lost;
+}
@@ -0,0 +1,76 @@
+/* CANopen traffic classes and node states
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_OPEN_H_
+#define CORE_SRC_CAN_OPEN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* Classes of the predefined connection set */
+typedef enum {
+    CAN_OPEN_OTHER,
+    CAN_OPEN_NMT,
+    CAN_OPEN_SYNC,
+    CAN_OPEN_EMCY,
+    CAN_OPEN_TIME,
+    CAN_OPEN_PDO,
+    CAN_OPEN_SDO,
+    CAN_OPEN_HEARTBEAT, /* NMT error control, boot-up included */
+    CAN_OPEN_LSS,
+    CAN_OPEN_CLASSES_COUNT
+} CanOpenClass;
+
+#define CAN_OPEN_NODES_COUNT (127u)
+
+/* NMT states reported by the heartbeat */
+#define CAN_OPEN_STATE_BOOT_UP (0u)
+#define CAN_OPEN_STATE_STOPPED (4u)
+#define CAN_OPEN_STATE_OPERATIONAL (5u)
+#define CAN_OPEN_STATE_PRE_OPERATIONAL (127u)
+#define CAN_OPEN_STATE_UNKNOWN (0xFFu) /* No heartbeat yet */
+
+/* Node flags */
+#define CAN_OPEN_NODE_PERIOD_VALID (0x01u)
+#define CAN_OPEN_NODE_LOST (0x02u) /* The heartbeat deadline is missed */
+
+/* 8 bytes per node */
+typedef struct {
+    uint32_t last_ms; /* Last heartbeat, ms of the 64-bit CPU ticks. Wraps after 49 days */
+    uint16_t period;    /* Heartbeat period, ms. Averaged, a missed heartbeat is not counted */
+    uint8_t state;
+    uint8_t flags;
+} CanOpenNode;
+
+typedef struct {
+    uint32_t ticks_per_ms;
+    CanOpenNode nodes[CAN_OPEN_NODES_COUNT]; /* Node 1 is at 0 */
+    uint32_t bus_bits[CAN_OPEN_CLASSES_COUNT];
+    uint32_t bus_bits_total; /* Halved at 2^31 with all classes */
+    uint32_t nmt_commands;
+    uint32_t heartbeat_misses;
+} CanOpen;
+
+/* A lookup in a 1 KB table of 4 bit classes, node ID is the low 7 bits */
+CanOpenClass CanOpenGetClass(uint32_t id);
+
+static inline uint32_t CanOpenGetNode(uint32_t id) {
+    return id & 0x7Fu;
+}
+
+void CanOpenInit(CanOpen *self, uint32_t ticks_per_ms);
+
+/* Standard frame, time in 64-bit CPU ticks, bits on the wire. O(1) */
+void CanOpenAddFrame(CanOpen *self, uint32_t id, const uint8_t data[], uint32_t size, uint64_t time, uint32_t bits);
+
+/* Mark the nodes without a heartbeat for CAN_OPEN_HEARTBEAT_MISSING_PERCENT of the period, in 64-bit CPU ticks.
+ * A node stays lost until its next heartbeat. O(CAN_OPEN_NODES_COUNT), call at the display rate.
+ * Returns the first lost node, 0 if none */
+uint32_t CanOpenCheck(CanOpen *self, uint64_t now);
+
+#endif /* CORE_SRC_CAN_OPEN_H_ */
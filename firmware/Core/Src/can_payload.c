@@ -0,0 +1,60 @@
+/* Payload bits that change, per identifier
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_payload.h"
+#include <assert.h>
+#include <string.h>
+
+void CanPayloadInit(CanPayload *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+/* Bytes 0..size-1 of the two words */
+static inline uint32_t CanPayloadGetMask(uint32_t size, uint32_t word) {
+    const uint32_t word_size = (size > (word * 4u)) ? (size - (word * 4u)) : 0u;
+    return (word_size >= 4u) ? 0xFFFFFFFFu : ((1u << (word_size * 8u)) - 1u);
+}
+
+void CanPayloadAdd(CanPayload *self, uint32_t index, const uint8_t data[8], uint32_t size, bool restart) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(index < CAN_ID_TABLE_SIZE);
+    assert(data != NULL);
+    assert(size <= 8u);
+
+    CanPayloadEntry *entry = &self->entries[index];
+    uint32_t words[2];
+    (void)memcpy(words, data, sizeof(words)); /* Little endian, byte 0 is the low byte */
+    words[0] &= CanPayloadGetMask(size, 0u);
+    words[1] &= CanPayloadGetMask(size, 1u);
+
+    if (restart) {
+        (void)memset(entry, 0, sizeof(*entry));
+    } else {
+        const uint32_t diff0 = words[0] ^ entry->data[0];
+        const uint32_t diff1 = words[1] ^ entry->data[1];
+        if ((diff0 | diff1) != 0u) {
+            entry->changed[0] |= diff0;
+            entry->changed[1] |= diff1;
+            entry->changed_frames++;
+        }
+    }
+    entry->data[0] = words[0];
+    entry->data[1] = words[1];
+}
+
+uint32_t CanPayloadGetByteActivity(const CanPayload *self, uint32_t index, uint32_t byte) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(index < CAN_ID_TABLE_SIZE);
+    assert(byte < 8u);
+
+    const uint32_t bits = (self->entries[index].changed[byte / 4u] >> ((byte % 4u) * 8u)) & 0xFFu;
+    return (uint32_t)__builtin_popcount(bits);
+}
@@ -0,0 +1,35 @@
+/* Payload bits that change, per identifier
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_PAYLOAD_H_
+#define CORE_SRC_CAN_PAYLOAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* Per CanIdTable entry, 20 bytes. Byte 0 of the payload is the low byte of data[0].
+ * A counter has changing low bits, a static frame none, a signal some */
+typedef struct {
+    uint32_t data[2];         /* The last payload, zero after the DLC */
+    uint32_t changed[2];      /* Bits that have ever changed */
+    uint32_t changed_frames;  /* Frames with a payload different from the previous one */
+} CanPayloadEntry;
+
+typedef struct {
+    CanPayloadEntry entries[CAN_ID_TABLE_SIZE];
+} CanPayload;
+
+void CanPayloadInit(CanPayload *self);
+
+/* Payload of the CanIdTable entry, restart if the entry has been given to a new identifier. Two 32 bit XORs */
+void CanPayloadAdd(CanPayload *self, uint32_t index, const uint8_t data[8], uint32_t size, bool restart);
+
+/* Number of bits of the payload byte that have ever changed, 0..8 */
+uint32_t CanPayloadGetByteActivity(const CanPayload *self, uint32_t index, uint32_t byte);
+
+#endif /* CORE_SRC_CAN_PAYLOAD_H_ */
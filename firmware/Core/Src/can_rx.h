@@ -0,0 +1,26 @@
+/* Register-level reading of the bxCAN receive FIFOs into the frame ring
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_RX_H_
+#define CORE_SRC_CAN_RX_H_
+
+#include <stdint.h>
+#include "can_frame_ring.h"
+
+#define CAN_RX_FIFOS_COUNT (2u)
+
+typedef struct {
+    uint32_t frames; /* Read from the FIFOs */
+    uint32_t cycles; /* CPU ticks spent in the interrupt */
+    uint32_t fifo_overruns[CAN_RX_FIFOS_COUNT]; /* Overrun flags seen, at least one frame lost each */
+} CanRx;
+
+void CanRxInit(CanRx *self);
+
+/* Interrupt handler body: moves all pending frames of the FIFO into the ring, bypassing HAL.
+ * entry_time is DWT->CYCCNT at the interrupt entry */
+void CanRxReadFifo(CanRx *self, CanFrameRing *ring, uint32_t fifo, uint32_t entry_time);
+
+#endif /* CORE_SRC_CAN_RX_H_ */
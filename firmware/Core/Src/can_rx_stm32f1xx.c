@@ -0,0 +1,66 @@
+/* Register-level reading of the bxCAN receive FIFOs into the frame ring
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "can_rx.h"
+#include "stm32f1xx_hal.h"
+
+#define CAN_RX_CAN CAN1
+
+void CanRxInit(CanRx *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+void CanRxReadFifo(CanRx *self, CanFrameRing *ring, uint32_t fifo, uint32_t entry_time) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(ring != NULL);
+    assert(fifo < CAN_RX_FIFOS_COUNT);
+
+    /* RF0R and RF1R have the same layout */
+    volatile uint32_t *const rfr = (fifo == 0u) ? &CAN_RX_CAN->RF0R : &CAN_RX_CAN->RF1R;
+    const CAN_FIFOMailBox_TypeDef *const mailbox = &CAN_RX_CAN->sFIFOMailBox[fifo];
+    uint32_t rf = *rfr;
+    if ((rf & CAN_RF0R_FOVR0) != 0u) {
+        *rfr = CAN_RF0R_FOVR0 | CAN_RF0R_FULL0;
+        self->fifo_overruns[fifo]++;
+    }
+    while ((rf & CAN_RF0R_FMP0) != 0u) {
+        CanFrameRecord *record = CanFrameRingBeginPush(ring);
+        if (record != NULL) {
+            const uint32_t rir = mailbox->RIR;
+            const uint32_t rdtr = mailbox->RDTR;
+            const uint32_t rdlr = mailbox->RDLR;
+            const uint32_t rdhr = mailbox->RDHR;
+            record->time = entry_time;
+            if ((rir & CAN_RI0R_IDE) != 0u) {
+                /* STID is the upper part of the 29-bit identifier */
+                record->id = (rir & (CAN_RI0R_STID_Msk | CAN_RI0R_EXID_Msk)) >> CAN_RI0R_EXID_Pos;
+                record->flags = CAN_FRAME_EXTENDED;
+            } else {
+                record->id = (rir & CAN_RI0R_STID_Msk) >> CAN_RI0R_STID_Pos;
+                record->flags = 0u;
+            }
+            if ((rir & CAN_RI0R_RTR) != 0u) {
+                record->flags |= CAN_FRAME_RTR;
+            }
+            record->dlc = (uint8_t)((rdtr & CAN_RDT0R_DLC_Msk) >> CAN_RDT0R_DLC_Pos);
+            (void)memcpy(&record->data[0], &rdlr, sizeof(rdlr)); /* Little endian, as on the bus */
+            (void)memcpy(&record->data[sizeof(rdlr)], &rdhr, sizeof(rdhr));
+            CanFrameRingEndPush(ring);
+        }
+        *rfr = CAN_RF0R_RFOM0;
+        self->frames++;
+        /* FMP is valid after the hardware has released the mailbox */
+        do {
+            rf = *rfr;
+        } while ((rf & CAN_RF0R_RFOM0) != 0u);
+    }
+    self->cycles += DWT->CYCCNT - entry_time;
+}
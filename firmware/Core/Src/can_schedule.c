@@ -0,0 +1,126 @@
+/* Learned periods of the identifiers and the frames out of schedule
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_schedule.h"
+#include <assert.h>
+#include <string.h>
+
+#define CAN_SCHEDULE_MAX_PERIOD (1u << 30u) /* 16.7 s, the deadline must be within 2^31 CPU ticks */
+
+void CanScheduleInit(CanSchedule *self, uint32_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+    CanWheelInit(&self->wheel, now);
+}
+
+static uint32_t CanScheduleMedian3(uint32_t a, uint32_t b, uint32_t c) {
+    if (a > b) {
+        const uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    if (b > c) {
+        b = c;
+    }
+    return (a > b) ? a : b;
+}
+
+/* Per identifier counters stay at the maximum */
+static inline uint16_t CanScheduleAddCount(uint16_t counter, uint32_t count) {
+    return (((uint32_t)UINT16_MAX - counter) < count) ? UINT16_MAX : (uint16_t)(counter + count);
+}
+
+static inline uint32_t CanSchedulePercent(uint32_t period, uint32_t percent) {
+    return (period / 100u) * percent;
+}
+
+static void CanScheduleLearn(CanScheduleEntry *entry, uint32_t period) {
+    if (entry->learn_count >= 2u) {
+        const uint32_t median = CanScheduleMedian3(entry->learn_periods[0], entry->learn_periods[1], period);
+        const uint32_t deviation = (period > median) ? (period - median) : (median - period);
+        if (deviation > CanSchedulePercent(median, CAN_SCHEDULE_TOLERANCE_PERCENT)) {
+            entry->learn_outliers++;
+        }
+        entry->period += median / CAN_SCHEDULE_LEARN_PERIODS;
+    }
+    entry->learn_periods[0] = entry->learn_periods[1];
+    entry->learn_periods[1] = period;
+    entry->learn_count++;
+}
+
+static void CanScheduleArm(CanSchedule *self, uint32_t index, uint32_t time) {
+    const CanScheduleEntry *entry = &self->entries[index];
+    CanWheelInsert(&self->wheel, index, time + CanSchedulePercent(entry->period, CAN_SCHEDULE_MISSING_PERCENT));
+}
+
+void CanScheduleAddFrame(CanSchedule *self, uint32_t index, uint32_t time, bool restart) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(index < CAN_ID_TABLE_SIZE);
+
+    CanScheduleEntry *entry = &self->entries[index];
+    if (restart) {
+        CanWheelRemove(&self->wheel, index);
+        (void)memset(entry, 0, sizeof(*entry));
+        entry->last_time = time;
+        return;
+    }
+
+    const uint32_t period = time - entry->last_time;
+    entry->last_time = time;
+    switch (entry->state) {
+        case CAN_SCHEDULE_LEARNING:
+            CanScheduleLearn(entry, period);
+            if (entry->learn_count == (CAN_SCHEDULE_LEARN_PERIODS + 2u)) {
+                if ((entry->learn_outliers > (CAN_SCHEDULE_LEARN_PERIODS / 2u)) || (entry->period == 0u) ||
+                    (entry->period > CAN_SCHEDULE_MAX_PERIOD)) {
+                    entry->state = CAN_SCHEDULE_APERIODIC;
+                } else {
+                    entry->state = CAN_SCHEDULE_PERIODIC;
+                    CanScheduleArm(self, index, time);
+                }
+            }
+            break;
+        case CAN_SCHEDULE_PERIODIC: {
+            const uint32_t tolerance = CanSchedulePercent(entry->period, CAN_SCHEDULE_TOLERANCE_PERCENT);
+            if (entry->missed) {
+                entry->missed = false;
+            } else if (period > (entry->period + tolerance)) {
+                entry->late = CanScheduleAddCount(entry->late, 1u);
+                self->late++;
+            } else if (period < (entry->period - tolerance)) {
+                entry->early = CanScheduleAddCount(entry->early, 1u);
+                self->early++;
+            } else {
+                /* On time */
+            }
+            CanScheduleArm(self, index, time);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void CanScheduleCheck(CanSchedule *self, uint32_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    uint32_t index = 0u;
+    while (CanWheelPop(&self->wheel, now, &index)) {
+        CanScheduleEntry *entry = &self->entries[index];
+        const uint32_t deadline = self->wheel.deadlines[index];
+
+        /* Every period passed since the deadline is another missing frame */
+        const uint32_t missing = ((now - deadline) / entry->period) + 1u;
+        entry->missing = CanScheduleAddCount(entry->missing, missing);
+        entry->missed = true;
+        self->missing += missing;
+        CanWheelInsert(&self->wheel, index, deadline + (missing * entry->period));
+    }
+}
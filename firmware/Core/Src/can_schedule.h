@@ -0,0 +1,55 @@
+/* Learned periods of the identifiers and the frames out of schedule
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_SCHEDULE_H_
+#define CORE_SRC_CAN_SCHEDULE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+#include "can_wheel.h"
+
+typedef enum {
+    CAN_SCHEDULE_LEARNING,
+    CAN_SCHEDULE_PERIODIC,
+    CAN_SCHEDULE_APERIODIC /* Event driven or too slow, not checked */
+} CanScheduleState;
+
+/* Per CanIdTable entry, 28 bytes. Periods in CPU ticks */
+typedef struct {
+    uint32_t period; /* Nominal. While learning, the sum of the filtered periods / CAN_SCHEDULE_LEARN_PERIODS */
+    uint32_t last_time;
+    uint32_t learn_periods[2]; /* The previous two, for the median of 3 */
+    uint16_t early;
+    uint16_t late;
+    uint16_t missing;
+    uint8_t learn_count;
+    uint8_t learn_outliers; /* Periods away from the median of 3 by more than the tolerance */
+    uint8_t state;          /* CanScheduleState */
+    bool missed;            /* Missing counted since the last frame, so the frame is not late */
+} CanScheduleEntry;
+
+/* The nominal period is the average of the median of 3 filtered periods of the first CAN_SCHEDULE_LEARN_PERIODS + 2
+ * frames, so a lost or delayed frame does not spoil it. Every frame is checked in O(1), and a missing frame expires
+ * from the timer wheel at CAN_SCHEDULE_MISSING_PERCENT of the period */
+typedef struct {
+    CanScheduleEntry entries[CAN_ID_TABLE_SIZE];
+    CanWheel wheel;
+    uint32_t early;
+    uint32_t late;
+    uint32_t missing;
+} CanSchedule;
+
+void CanScheduleInit(CanSchedule *self, uint32_t now);
+
+/* Frame of the CanIdTable entry, restart if the entry has been given to a new identifier */
+void CanScheduleAddFrame(CanSchedule *self, uint32_t index, uint32_t time, bool restart);
+
+/* Count the missing frames up to now. After all frames received before now are added */
+void CanScheduleCheck(CanSchedule *self, uint32_t now);
+
+#endif /* CORE_SRC_CAN_SCHEDULE_H_ */
@@ -0,0 +1,71 @@
+/* Signals of the received frames decoded by the tables compiled from a DBC file
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_signal.h"
+#include <assert.h>
+#include <string.h>
+
+void CanSignalValuesInit(CanSignalValues *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+const CanSignalMessage *CanSignalFindMessage(const CanSignalTables *tables, uint32_t key) {
+    /* Check parameters */
+    assert(tables != NULL);
+
+    uint32_t low = 0u;
+    uint32_t high = tables->messages_count;
+    while (low < high) {
+        const uint32_t middle = low + ((high - low) / 2u);
+        const CanSignalMessage *message = &tables->messages[middle];
+        if (message->key == key) {
+            return message;
+        }
+        if (message->key < key) {
+            low = middle + 1u;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+void CanSignalValuesAddFrame(CanSignalValues *self, const CanSignalTables *tables, uint32_t key,
+                             const uint8_t data[], uint32_t size) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(tables != NULL);
+    assert(data != NULL);
+    assert(size <= 8u);
+
+    const CanSignalMessage *message = CanSignalFindMessage(tables, key);
+    if ((message == NULL) || (message->first_signal >= CAN_SIGNAL_VALUES_SIZE)) {
+        return;
+    }
+
+    /* The bytes after the payload are zero, Cortex-M3 is little endian */
+    uint8_t payload[8] = {};
+    (void)memcpy(payload, data, size);
+    uint64_t little = 0u;
+    (void)memcpy(&little, payload, sizeof(little));
+    const uint64_t big = __builtin_bswap64(little);
+
+    uint32_t end = (uint32_t)message->first_signal + message->signals_count;
+    if (end > CAN_SIGNAL_VALUES_SIZE) {
+        end = CAN_SIGNAL_VALUES_SIZE;
+    }
+    uint32_t i = 0u;
+    for (i = message->first_signal; i < end; i++) {
+        const CanSignal *signal = &tables->signals[i];
+        if (size >= signal->min_size) {
+            self->values[i] = CanSignalExtract(signal, little, big);
+            self->valid |= 1u << i;
+        }
+    }
+}
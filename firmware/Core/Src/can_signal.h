@@ -0,0 +1,78 @@
+/* Signals of the received frames decoded by the tables compiled from a DBC file
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_SIGNAL_H_
+#define CORE_SRC_CAN_SIGNAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+/* Signal flags */
+#define CAN_SIGNAL_BIG_ENDIAN (0x01u) /* Motorola byte order, extracted from the byte swapped payload */
+#define CAN_SIGNAL_SIGNED (0x02u)
+
+#define CAN_SIGNAL_NAME_SIZE (8u) /* With the terminating zero */
+#define CAN_SIGNAL_UNIT_SIZE (4u)
+
+/* 32 bytes per signal. The value is ((payload >> shift) & mask) * factor + offset in units of 10^-decimals */
+typedef struct {
+    uint64_t mask;
+    int32_t factor;
+    int32_t offset;
+    uint8_t shift;
+    uint8_t flags;
+    uint8_t min_size; /* Payload bytes that hold the signal */
+    uint8_t decimals;
+    char name[CAN_SIGNAL_NAME_SIZE];
+    char unit[CAN_SIGNAL_UNIT_SIZE];
+} CanSignal;
+
+/* 8 bytes per message, sorted by key */
+typedef struct {
+    uint32_t key; /* CanIdTableMakeKey, the same as the DBC message ID */
+    uint16_t first_signal;
+    uint8_t signals_count;
+} CanSignalMessage;
+
+typedef struct {
+    const CanSignalMessage *messages;
+    uint32_t messages_count;
+    const CanSignal *signals;
+    uint32_t signals_count;
+} CanSignalTables;
+
+/* Generated by Additional/dbc/preparedbc into can_signals.c, in flash */
+extern const CanSignalTables can_signals;
+
+/* The last values of the first CAN_SIGNAL_VALUES_SIZE signals of the tables */
+typedef struct {
+    int64_t values[CAN_SIGNAL_VALUES_SIZE];
+    uint32_t valid; /* A bit per value */
+} CanSignalValues;
+
+void CanSignalValuesInit(CanSignalValues *self);
+
+/* Binary search. NULL if the message is not in the tables */
+const CanSignalMessage *CanSignalFindMessage(const CanSignalTables *tables, uint32_t key);
+
+/* A mask and a shift over the 64 bit payload word, little is the payload as is, big is byte swapped */
+static inline int64_t CanSignalExtract(const CanSignal *signal, uint64_t little, uint64_t big) {
+    const uint64_t word = ((signal->flags & CAN_SIGNAL_BIG_ENDIAN) != 0u) ? big : little;
+    int64_t raw = (int64_t)((word >> signal->shift) & signal->mask);
+    if ((signal->flags & CAN_SIGNAL_SIGNED) != 0u) {
+        const int64_t sign = (int64_t)((signal->mask >> 1u) + 1u);
+        raw = (raw ^ sign) - sign;
+    }
+    return (raw * signal->factor) + signal->offset;
+}
+
+/* Decode the signals of the frame. O(log messages + signals of the message) */
+void CanSignalValuesAddFrame(CanSignalValues *self, const CanSignalTables *tables, uint32_t key,
+                             const uint8_t data[], uint32_t size);
+
+#endif /* CORE_SRC_CAN_SIGNAL_H_ */
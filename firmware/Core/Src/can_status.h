@@ -0,0 +1,41 @@
+/* bxCAN error status register sampling
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_STATUS_H_
+#define CORE_SRC_CAN_STATUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Last error codes */
+#define CAN_STATUS_LEC_NONE (0u)
+#define CAN_STATUS_LEC_STUFF (1u)
+#define CAN_STATUS_LEC_FORM (2u)
+#define CAN_STATUS_LEC_ACK (3u)
+#define CAN_STATUS_LEC_BIT_RECESSIVE (4u)
+#define CAN_STATUS_LEC_BIT_DOMINANT (5u)
+#define CAN_STATUS_LEC_CRC (6u)
+#define CAN_STATUS_LEC_SOFTWARE (7u) /* Written after every sample to see the next error */
+#define CAN_STATUS_LEC_COUNT (8u)
+
+/* Error state flags */
+#define CAN_STATUS_WARNING (0x01u)
+#define CAN_STATUS_PASSIVE (0x02u)
+#define CAN_STATUS_BUS_OFF (0x04u)
+
+typedef struct {
+    uint32_t lec_counts[CAN_STATUS_LEC_COUNT]; /* Samples that found the code */
+    uint32_t errors;                        /* Sum of lec_counts */
+    uint8_t tec;                            /* Transmit error counter */
+    uint8_t rec;                            /* Receive error counter */
+    uint8_t flags;
+} CanStatus;
+
+void CanStatusInit(CanStatus *self);
+
+/* Cheap, call from the main loop. Errors closer than the sample period are counted once */
+void CanStatusSample(CanStatus *self);
+
+#endif /* CORE_SRC_CAN_STATUS_H_ */
@@ -0,0 +1,38 @@
+/* bxCAN error status register sampling
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "can_status.h"
+#include "stm32f1xx_hal.h"
+
+#define CAN_STATUS_CAN CAN1
+
+void CanStatusInit(CanStatus *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+    CAN_STATUS_CAN->ESR = CAN_STATUS_LEC_SOFTWARE << CAN_ESR_LEC_Pos;
+}
+
+void CanStatusSample(CanStatus *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    const uint32_t esr = CAN_STATUS_CAN->ESR;
+    const uint32_t lec = (esr & CAN_ESR_LEC_Msk) >> CAN_ESR_LEC_Pos;
+    if ((lec != CAN_STATUS_LEC_NONE) && (lec != CAN_STATUS_LEC_SOFTWARE)) {
+        self->lec_counts[lec]++;
+        self->errors++;
+        /* Only LEC is writable */
+        CAN_STATUS_CAN->ESR = CAN_STATUS_LEC_SOFTWARE << CAN_ESR_LEC_Pos;
+    }
+    self->tec = (uint8_t)((esr & CAN_ESR_TEC_Msk) >> CAN_ESR_TEC_Pos);
+    self->rec = (uint8_t)((esr & CAN_ESR_REC_Msk) >> CAN_ESR_REC_Pos);
+    self->flags = (((esr & CAN_ESR_EWGF) != 0u) ? CAN_STATUS_WARNING : 0u) |
+                  (((esr & CAN_ESR_EPVF) != 0u) ? CAN_STATUS_PASSIVE : 0u) |
+                  (((esr & CAN_ESR_BOFF) != 0u) ? CAN_STATUS_BUS_OFF : 0u);
+}
@@ -0,0 +1,112 @@
+/* Identifiers with the largest share of the bus time
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_top.h"
+#include <assert.h>
+#include <string.h>
+
+#if CAN_TOP_SIZE > CAN_ID_TABLE_SIZE
+#error CAN_TOP_SIZE is larger than the identifier table
+#endif
+
+void CanTopInit(CanTop *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+}
+
+static inline uint32_t CanTopGetBits(const CanIdTable *table, uint16_t index) {
+    return table->entries[index].bus_bits;
+}
+
+static void CanTopSwap(CanTop *self, uint32_t a, uint32_t b) {
+    const uint16_t index = self->heap[a];
+    self->heap[a] = self->heap[b];
+    self->heap[b] = index;
+}
+
+static uint32_t CanTopSiftUp(CanTop *self, const CanIdTable *table, uint32_t position) {
+    while (position > 0u) {
+        const uint32_t parent = (position - 1u) / 2u;
+        if (CanTopGetBits(table, self->heap[parent]) <= CanTopGetBits(table, self->heap[position])) {
+            break;
+        }
+        CanTopSwap(self, parent, position);
+        position = parent;
+    }
+    return position;
+}
+
+static void CanTopSiftDown(CanTop *self, const CanIdTable *table, uint32_t position) {
+    for (;;) {
+        uint32_t smallest = position;
+        const uint32_t left = (position * 2u) + 1u;
+        const uint32_t right = left + 1u;
+        if ((left < self->count) &&
+            (CanTopGetBits(table, self->heap[left]) < CanTopGetBits(table, self->heap[smallest]))) {
+            smallest = left;
+        }
+        if ((right < self->count) &&
+            (CanTopGetBits(table, self->heap[right]) < CanTopGetBits(table, self->heap[smallest]))) {
+            smallest = right;
+        }
+        if (smallest == position) {
+            break;
+        }
+        CanTopSwap(self, smallest, position);
+        position = smallest;
+    }
+}
+
+void CanTopUpdate(CanTop *self, const CanIdTable *table, uint32_t index) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(table != NULL);
+    assert(index < CAN_ID_TABLE_SIZE);
+
+    uint32_t position = 0u;
+    for (position = 0u; position < self->count; position++) {
+        if (self->heap[position] == index) {
+            /* A reused slot has fewer bits, a grown entry has more */
+            CanTopSiftDown(self, table, CanTopSiftUp(self, table, position));
+            return;
+        }
+    }
+    if (self->count < CAN_TOP_SIZE) {
+        self->heap[self->count] = (uint16_t)index;
+        self->count++;
+        (void)CanTopSiftUp(self, table, self->count - 1u);
+    } else if (CanTopGetBits(table, (uint16_t)index) > CanTopGetBits(table, self->heap[0])) {
+        self->heap[0] = (uint16_t)index;
+        CanTopSiftDown(self, table, 0u);
+    } else {
+        /* Not in the top */
+    }
+}
+
+uint32_t CanTopGet(const CanTop *self, const CanIdTable *table, uint16_t indexes[], uint32_t max_count) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(table != NULL);
+    assert(indexes != NULL);
+
+    /* Insertion sort of at most CAN_TOP_SIZE entries */
+    uint16_t sorted[CAN_TOP_SIZE];
+    uint32_t i = 0u;
+    for (i = 0u; i < self->count; i++) {
+        const uint16_t index = self->heap[i];
+        uint32_t j = i;
+        while ((j > 0u) && (CanTopGetBits(table, sorted[j - 1u]) < CanTopGetBits(table, index))) {
+            sorted[j] = sorted[j - 1u];
+            j--;
+        }
+        sorted[j] = index;
+    }
+    const uint32_t count = (self->count < max_count) ? self->count : max_count;
+    (void)memcpy(indexes, sorted, count * sizeof(indexes[0]));
+    return count;
+}
@@ -0,0 +1,31 @@
+/* Identifiers with the largest share of the bus time
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_TOP_H_
+#define CORE_SRC_CAN_TOP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+#include "can_id_table.h"
+
+/* Min-heap of CanIdTable entry indexes by bus_bits, the root is the smallest of the top.
+ * Updated on every frame, so nothing is sorted on a display refresh */
+typedef struct {
+    uint16_t heap[CAN_TOP_SIZE];
+    uint32_t count;
+} CanTop;
+
+void CanTopInit(CanTop *self);
+
+/* The entry bus_bits has grown, or the slot has been reused for another identifier. O(CAN_TOP_SIZE) */
+void CanTopUpdate(CanTop *self, const CanIdTable *table, uint32_t index);
+
+/* Entry indexes, the largest bus_bits first. Returns the count */
+uint32_t CanTopGet(const CanTop *self, const CanIdTable *table, uint16_t indexes[], uint32_t max_count);
+
+#endif /* CORE_SRC_CAN_TOP_H_ */
@@ -0,0 +1,116 @@
+/* Trigger on a frame, an error or the load with the frames before and after the event
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_trigger.h"
+#include <assert.h>
+#include <string.h>
+
+void CanTriggerInit(CanTrigger *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, 0, sizeof(*self));
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_TRIGGER_RULES; i++) {
+        self->rules[i].key = CAN_TRIGGER_NEVER;
+        self->rules[i].key_mask = CAN_TRIGGER_NEVER;
+    }
+    self->state = CAN_TRIGGER_IDLE;
+    self->cause = CAN_TRIGGER_CAUSE_NONE;
+}
+
+void CanTriggerSetRule(CanTrigger *self, uint32_t index, uint32_t key, uint32_t key_mask, uint64_t data,
+                       uint64_t data_mask) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(index < CAN_TRIGGER_RULES);
+    assert(self->state != CAN_TRIGGER_ARMED);
+
+    CanTriggerRule *rule = &self->rules[index];
+    rule->key = key & key_mask;
+    rule->key_mask = key_mask;
+    rule->data = data & data_mask;
+    rule->data_mask = data_mask;
+}
+
+void CanTriggerArm(CanTrigger *self) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    self->written = 0u;
+    self->position = 0u;
+    self->time = 0u;
+    self->state = CAN_TRIGGER_ARMED;
+    self->cause = CAN_TRIGGER_CAUSE_NONE;
+}
+
+static bool CanTriggerMatch(const CanTrigger *self, const CanFrameRecord *frame, uint32_t key) {
+    uint32_t size = ((frame->flags & CAN_FRAME_RTR) != 0u) ? 0u : frame->dlc;
+    if (size > CAN_FRAME_MAX_DATA) {
+        size = CAN_FRAME_MAX_DATA;
+    }
+    /* Cortex-M3 is little endian */
+    uint64_t data = 0u;
+    (void)memcpy(&data, frame->data, sizeof(data));
+    data &= (size == CAN_FRAME_MAX_DATA) ? UINT64_MAX : ((1ull << (size * 8u)) - 1u);
+
+    uint32_t matched = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_TRIGGER_RULES; i++) {
+        const CanTriggerRule *rule = &self->rules[i];
+        const uint64_t difference =
+            ((uint64_t)((key & rule->key_mask) ^ rule->key)) | ((data & rule->data_mask) ^ rule->data);
+        matched |= (difference == 0u) ? 1u : 0u;
+    }
+    return matched != 0u;
+}
+
+void CanTriggerAddFrame(CanTrigger *self, const CanFrameRecord *frame, uint32_t key) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(frame != NULL);
+
+    if ((self->state == CAN_TRIGGER_IDLE) || (self->state == CAN_TRIGGER_DONE)) {
+        return;
+    }
+
+    self->frames[self->written % CAN_TRIGGER_CAPTURE_SIZE] = *frame;
+    self->written++;
+
+    if ((self->state == CAN_TRIGGER_ARMED) && CanTriggerMatch(self, frame, key)) {
+        self->position = self->written - 1u;
+        self->time = frame->time;
+        self->cause = CAN_TRIGGER_CAUSE_FRAME;
+        self->state = CAN_TRIGGER_FIRED;
+    }
+    if ((self->state == CAN_TRIGGER_FIRED) && ((self->written - self->position) >= CAN_TRIGGER_POST_FRAMES)) {
+        self->state = CAN_TRIGGER_DONE;
+    }
+}
+
+void CanTriggerFire(CanTrigger *self, CanTriggerCause cause, uint32_t time) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(cause != CAN_TRIGGER_CAUSE_NONE);
+
+    if (self->state == CAN_TRIGGER_ARMED) {
+        self->position = self->written;
+        self->time = time;
+        self->cause = cause;
+        self->state = CAN_TRIGGER_FIRED;
+    }
+}
+
+const CanFrameRecord *CanTriggerGetFrame(const CanTrigger *self, uint32_t index, int32_t *offset) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(index < CanTriggerGetCount(self));
+    assert(offset != NULL);
+
+    const uint32_t number = (self->written - CanTriggerGetCount(self)) + index;
+    *offset = (int32_t)(number - self->position);
+    return &self->frames[number % CAN_TRIGGER_CAPTURE_SIZE];
+}
@@ -0,0 +1,80 @@
+/* Trigger on a frame, an error or the load with the frames before and after the event
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_TRIGGER_H_
+#define CORE_SRC_CAN_TRIGGER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+#include "can_frame_ring.h"
+
+#define CAN_TRIGGER_CAPTURE_SIZE (CAN_TRIGGER_PRE_FRAMES + CAN_TRIGGER_POST_FRAMES)
+
+/* No frame has this key, bits 29 and 30 of a key are zero */
+#define CAN_TRIGGER_NEVER (0xFFFFFFFFu)
+
+typedef enum {
+    CAN_TRIGGER_IDLE,
+    CAN_TRIGGER_ARMED, /* The last CAN_TRIGGER_PRE_FRAMES frames are kept */
+    CAN_TRIGGER_FIRED, /* Collecting CAN_TRIGGER_POST_FRAMES frames */
+    CAN_TRIGGER_DONE   /* The capture is frozen */
+} CanTriggerState;
+
+typedef enum {
+    CAN_TRIGGER_CAUSE_NONE,
+    CAN_TRIGGER_CAUSE_FRAME,
+    CAN_TRIGGER_CAUSE_ERROR,
+    CAN_TRIGGER_CAUSE_LOAD
+} CanTriggerCause;
+
+/* Compiled frame rule, 24 bytes. The values are masked, the payload is little endian, byte 0 is the low byte */
+typedef struct {
+    uint64_t data;
+    uint64_t data_mask;
+    uint32_t key; /* CanIdTableMakeKey */
+    uint32_t key_mask;
+} CanTriggerRule;
+
+/* The capture is a static pool, so arming never allocates. It is a plain array of CanFrameRecord,
+ * a debugger exports it by the symbol */
+typedef struct {
+    CanTriggerRule rules[CAN_TRIGGER_RULES];
+    CanFrameRecord frames[CAN_TRIGGER_CAPTURE_SIZE]; /* Circular while armed */
+    uint32_t written;                                /* Frames since arming */
+    uint32_t position;                               /* The first frame at or after the event, of written */
+    uint32_t time;                                   /* Of the event, CPU ticks */
+    CanTriggerState state;
+    CanTriggerCause cause;
+} CanTrigger;
+
+/* Every rule never matches, the trigger is idle */
+void CanTriggerInit(CanTrigger *self);
+
+/* A frame matches when (key & key_mask) and (payload & data_mask) equal the values.
+ * The bytes after the DLC are zero. The rules are compiled while the trigger is not armed */
+void CanTriggerSetRule(CanTrigger *self, uint32_t index, uint32_t key, uint32_t key_mask, uint64_t data,
+                       uint64_t data_mask);
+
+/* Start a new capture, the previous one is lost */
+void CanTriggerArm(CanTrigger *self);
+
+/* Every received frame. O(CAN_TRIGGER_RULES), all rules are evaluated without an early exit */
+void CanTriggerAddFrame(CanTrigger *self, const CanFrameRecord *frame, uint32_t key);
+
+/* An event outside the frames: an error or the load. The frames read after it are the post trigger frames */
+void CanTriggerFire(CanTrigger *self, CanTriggerCause cause, uint32_t time);
+
+/* Frames in the capture */
+static inline uint32_t CanTriggerGetCount(const CanTrigger *self) {
+    return (self->written < CAN_TRIGGER_CAPTURE_SIZE) ? self->written : CAN_TRIGGER_CAPTURE_SIZE;
+}
+
+/* The oldest frame is 0. The offset is from the event, negative before it */
+const CanFrameRecord *CanTriggerGetFrame(const CanTrigger *self, uint32_t index, int32_t *offset);
+
+#endif /* CORE_SRC_CAN_TRIGGER_H_ */
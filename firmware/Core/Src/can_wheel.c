@@ -0,0 +1,96 @@
+/* Timer wheel of deadlines in CPU ticks
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#include "can_wheel.h"
+#include <assert.h>
+#include <string.h>
+
+#if (CAN_WHEEL_SLOTS & (CAN_WHEEL_SLOTS - 1u)) != 0u
+#error CAN_WHEEL_SLOTS must be a power of two
+#endif
+
+#if (CAN_WHEEL_SLOTS > CAN_WHEEL_NONE) || (CAN_ID_TABLE_SIZE > CAN_WHEEL_NONE)
+#error The wheel links are 8 bit
+#endif
+
+void CanWheelInit(CanWheel *self, uint32_t now) {
+    /* Check parameters */
+    assert(self != NULL);
+
+    (void)memset(self, CAN_WHEEL_NONE, sizeof(*self));
+    self->tick = now >> CAN_WHEEL_TICK_SHIFT;
+}
+
+void CanWheelInsert(CanWheel *self, uint32_t node, uint32_t deadline) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(node < CAN_ID_TABLE_SIZE);
+
+    CanWheelRemove(self, node);
+
+    /* A passed tick is not scanned again */
+    uint32_t tick = deadline >> CAN_WHEEL_TICK_SHIFT;
+    if ((int32_t)(tick - self->tick) < 0) {
+        tick = self->tick;
+    }
+    const uint8_t slot = (uint8_t)(tick & (CAN_WHEEL_SLOTS - 1u));
+    const uint8_t head = self->heads[slot];
+    self->next[node] = head;
+    self->prev[node] = CAN_WHEEL_NONE;
+    if (head != CAN_WHEEL_NONE) {
+        self->prev[head] = (uint8_t)node;
+    }
+    self->heads[slot] = (uint8_t)node;
+    self->slots[node] = slot;
+    self->deadlines[node] = deadline;
+}
+
+void CanWheelRemove(CanWheel *self, uint32_t node) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(node < CAN_ID_TABLE_SIZE);
+
+    const uint8_t slot = self->slots[node];
+    if (slot == CAN_WHEEL_NONE) {
+        return;
+    }
+    const uint8_t next = self->next[node];
+    const uint8_t prev = self->prev[node];
+    if (prev == CAN_WHEEL_NONE) {
+        self->heads[slot] = next;
+    } else {
+        self->next[prev] = next;
+    }
+    if (next != CAN_WHEEL_NONE) {
+        self->prev[next] = prev;
+    }
+    self->slots[node] = CAN_WHEEL_NONE;
+}
+
+bool CanWheelPop(CanWheel *self, uint32_t now, uint32_t *node) {
+    /* Check parameters */
+    assert(self != NULL);
+    assert(node != NULL);
+
+    /* The current tick is not over, its deadlines may be later than now */
+    const uint32_t now_tick = now >> CAN_WHEEL_TICK_SHIFT;
+    if ((now_tick - self->tick) > CAN_WHEEL_SLOTS) {
+        self->tick = now_tick - CAN_WHEEL_SLOTS; /* A turn scans every slot */
+    }
+    while (self->tick != now_tick) {
+        uint8_t i = self->heads[self->tick & (CAN_WHEEL_SLOTS - 1u)];
+        while (i != CAN_WHEEL_NONE) {
+            if ((int32_t)(now - self->deadlines[i]) >= 0) {
+                CanWheelRemove(self, i);
+                *node = i;
+                return true;
+            }
+            i = self->next[i];
+        }
+        self->tick++;
+    }
+    return false;
+}
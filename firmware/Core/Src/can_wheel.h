@@ -0,0 +1,38 @@
+/* Timer wheel of deadlines in CPU ticks
+ * MISRA
+ * License: GPL
+ * Copyright (c) Aleksey Morozov aleksey.f.morozov@gmail.com
+ */
+
+#ifndef CORE_SRC_CAN_WHEEL_H_
+#define CORE_SRC_CAN_WHEEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "can_config.h"
+
+#define CAN_WHEEL_NONE (0xFFu)
+
+/* A node per CanIdTable entry, in the slot of its deadline tick. Deadlines further than a turn stay in the slot
+ * and are skipped until their turn. Insert and remove are O(1), a slot is scanned once per tick */
+typedef struct {
+    uint32_t tick; /* The next tick to process */
+    uint8_t heads[CAN_WHEEL_SLOTS];
+    uint8_t next[CAN_ID_TABLE_SIZE];
+    uint8_t prev[CAN_ID_TABLE_SIZE];
+    uint8_t slots[CAN_ID_TABLE_SIZE]; /* CAN_WHEEL_NONE if not in the wheel */
+    uint32_t deadlines[CAN_ID_TABLE_SIZE];
+} CanWheel;
+
+void CanWheelInit(CanWheel *self, uint32_t now);
+
+/* The node is moved if it is in the wheel already. A passed deadline expires on the next pop */
+void CanWheelInsert(CanWheel *self, uint32_t node, uint32_t deadline);
+
+void CanWheelRemove(CanWheel *self, uint32_t node);
+
+/* Removes a node whose deadline is not after now. Returns false if there is none in the passed ticks */
+bool CanWheelPop(CanWheel *self, uint32_t now, uint32_t *node);
+
+#endif /* CORE_SRC_CAN_WHEEL_H_ */
@@ -0,0 +1,7 @@
+/* License: GPL
+ * Copyright (c) Alemorf aleksey.f.morozov@gmail.com
+ */
+
+#include "delay_cpu_cycles.h"
+
+volatile uint32_t cpu_cycles_epoch = 0u;
@@ -14,9 +14,16 @@
 #define US_TO_CPU_TICKS(us) ((uint32_t)(((((uint64_t)(us)) * CPU_FREQ) + 999999u) / 1000000u))
 #define MS_TO_CPU_TICKS(ms) ((uint32_t)(((((uint64_t)(ms)) * CPU_FREQ) + 999u) / 1000u))
 
+/* Upper 32 bits of the 64-bit cycle counter (DWT->CYCCNT wraps every 67 s at 64 MHz) and the most
+ * significant bit of DWT->CYCCNT at the last update, packed into one word so that a single load is consistent */
+extern volatile uint32_t cpu_cycles_epoch;
+
+#define CPU_CYCLES_EPOCH_MSB_SHIFT (31u)
+
 static inline void EnableDwt(void) {
     CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
     DWT->CYCCNT = 0;
+    cpu_cycles_epoch = 0u;
     DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
@@ -32,4 +39,32 @@ static inline uint32_t GetCpuCycles() {
     return DWT->CYCCNT;
 }
 
+/* The low word is ahead of the epoch if it wrapped after the last update */
+static inline uint64_t MakeCpuCycles64(uint32_t epoch, uint32_t cycles) {
+    uint32_t high = epoch >> 1u;
+    if (((epoch & 1u) != 0u) && ((cycles >> CPU_CYCLES_EPOCH_MSB_SHIFT) == 0u)) {
+        high++;
+    }
+    return ((uint64_t)high << 32u) | cycles;
+}
+
+/* Monotonic 64-bit CPU ticks. Safe from any context, no interrupts are disabled */
+static inline uint64_t GetCpuCycles64(void) {
+    const uint32_t epoch = cpu_cycles_epoch;
+    return MakeCpuCycles64(epoch, DWT->CYCCNT);
+}
+
+/* A 32-bit time of the last 2^32 CPU ticks before now, such as DWT->CYCCNT saved by an interrupt, as 64 bit */
+static inline uint64_t ExtendCpuCycles(uint64_t now, uint32_t cycles) {
+    return now - (uint32_t)((uint32_t)now - cycles);
+}
+
+/* Must be called more often than every 33 s, from SysTick_Handler */
+static inline void UpdateCpuCycles64(void) {
+    const uint64_t cycles = MakeCpuCycles64(cpu_cycles_epoch, DWT->CYCCNT);
+    const uint32_t high = (uint32_t)(cycles >> 32u);
+    const uint32_t msb = (uint32_t)cycles >> CPU_CYCLES_EPOCH_MSB_SHIFT;
+    cpu_cycles_epoch = (high << 1u) | msb;
+}
+
 #endif /* CORE_SRC_DELAY_CPU_CYCLES_H_ */
@@ -5,6 +5,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include "delay_cpu_cycles.h"
 #include "mt12232a.h"
 #include "my.h"
@@ -12,35 +13,501 @@
 #include "fonts.h"
 #include "main.h"
 #include "math.h"
+#include "can_config.h"
+#include "can_load.h"
+#include "can_capture.h"
+#include "can_gated.h"
+#include "can_decoder.h"
+#include "can_autobaud.h"
+#include "can_history.h"
+#include "can_metrics.h"
+#include "can_status.h"
+#include "can_gaps.h"
+#include "can_governor.h"
+#include "can_glitch.h"
+#include "can_frame_ring.h"
+#include "can_rx.h"
+#include "can_id_table.h"
+#include "can_top.h"
+#include "can_frame_length.h"
+#include "can_schedule.h"
+#include "can_payload.h"
+#include "can_j1939.h"
+#include "can_isotp.h"
+#include "can_open.h"
+#include "can_signal.h"
+#include "can_trigger.h"
+#include "can_filter.h"
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+#endif
 
 static Mt12232a mt12232a;
 volatile uint32_t can_rx_counter = 0;
 
-void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef* hcan) {
+static CanMetrics can_metrics; /* Everything the main loop shows */
+
+static CanFrameRing can_frame_ring;
+static CanRx can_rx;
+static uint32_t can_rx_irq_time = 0;
+static uint32_t can_rx_frames = 0;
+static uint32_t can_rx_busy_time = 0; /* Exact lengths of the received frames, CPU ticks */
+static CanIdTable can_id_table;
+static CanTop can_top;
+static CanSchedule can_schedule;
+static CanPayload can_payload;
+static CanSignalValues can_signal_values;
+#if CAN_TRIGGER != 0u
+static CanTrigger can_trigger;
+static uint32_t trigger_errors_prev = 0u;
+#endif
+#if CAN_J1939 != 0u
+static CanJ1939 can_j1939;
+#endif
+#if CAN_ISOTP != 0u
+static CanIsoTp can_isotp;
+#endif
+#if CAN_CANOPEN != 0u
+static CanOpen can_open;
+#endif
+static uint32_t can_bitrate = CAN_BITRATE;
+
+/* Both FIFO interrupts have the same priority, so the ring has a single producer.
+ * Returns true if the frames have been read without HAL */
+static bool CanRxIrqHandler(uint32_t fifo) {
+    const uint32_t time = DWT->CYCCNT;
+#if CAN_RX_FAST_PATH != 0u
+    CanRxReadFifo(&can_rx, &can_frame_ring, fifo, time);
+    return true;
+#else
+    (void)fifo;
+    can_rx_irq_time = time;
+    return false;
+#endif
+}
+
+bool CanRx0IrqHandler(void) {
+    return CanRxIrqHandler(0u);
+}
+
+void CanRx1IrqHandler(void) {
+    if (CanRxIrqHandler(1u) == false) {
+        HAL_CAN_IRQHandler(&hcan);
+        CanRxIrqExit();
+    }
+}
+
+/* After HAL_CAN_IRQHandler */
+void CanRxIrqExit(void) {
+    can_rx.cycles += DWT->CYCCNT - can_rx_irq_time;
+}
+
+/* Frames are only queued here, they are processed in the main loop */
+static void ReceiveHal(CAN_HandleTypeDef* hcan, uint32_t fifo) {
     CAN_RxHeaderTypeDef can_message_header = {};
-    uint8_t can_message_payload[8] = {};
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &can_message_header, can_message_payload) == HAL_OK) {
-        /* TODO(Any): Process CAN message */
+    can_rx.frames++;
+    CanFrameRecord* record = CanFrameRingBeginPush(&can_frame_ring);
+    if (record == NULL) {
+        /* Release the FIFO anyway */
+        uint8_t can_message_payload[CAN_FRAME_MAX_DATA] = {};
+        (void)HAL_CAN_GetRxMessage(hcan, fifo, &can_message_header, can_message_payload);
+        return;
+    }
+    if (HAL_CAN_GetRxMessage(hcan, fifo, &can_message_header, record->data) == HAL_OK) {
+        record->time = can_rx_irq_time;
+        record->id = (can_message_header.IDE == CAN_ID_EXT) ? can_message_header.ExtId : can_message_header.StdId;
+        record->dlc = (uint8_t)can_message_header.DLC;
+        record->flags = ((can_message_header.IDE == CAN_ID_EXT) ? CAN_FRAME_EXTENDED : 0u) |
+                        ((can_message_header.RTR == CAN_RTR_REMOTE) ? CAN_FRAME_RTR : 0u);
+        CanFrameRingEndPush(&can_frame_ring);
+    }
+}
+
+void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef* hcan) {
+    ReceiveHal(hcan, CAN_RX_FIFO0);
+}
+
+void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef* hcan) {
+    ReceiveHal(hcan, CAN_RX_FIFO1);
+}
+
+void HAL_CAN_ErrorCallback(CAN_HandleTypeDef* hcan) {
+    if ((hcan->ErrorCode & HAL_CAN_ERROR_RX_FOV0) != 0u) {
+        can_rx.fifo_overruns[0]++;
+    }
+    if ((hcan->ErrorCode & HAL_CAN_ERROR_RX_FOV1) != 0u) {
+        can_rx.fifo_overruns[1]++;
+    }
+    (void)HAL_CAN_ResetError(hcan);
+}
+
+#if CAN_FILTER_FOCUS != 0u
+static const CanFilterRange can_filter_wanted[] = CAN_FILTER_WANTED;
+static uint32_t can_filter_banks = 0u;
+static uint32_t can_filter_false_percent = 0u; /* Of the identifiers passed by the banks */
+static uint32_t can_filter_false_frames = 0u;
+static uint32_t can_filter_wanted_frames = 0u; /* Decoded from the edges */
+
+/* The synthesized banks alternate between FIFO 0 and FIFO 1 */
+static void ConfigCanFilters(void) {
+    CanFilterSet set;
+    CanFilterSynthesize(&set, can_filter_wanted, ARRAY_SIZE(can_filter_wanted));
+    can_filter_banks = set.banks_count;
+    can_filter_false_percent = CanFilterGetFalsePercent(&set);
+
+    CAN_FilterTypeDef can_filter_config;
+    can_filter_config.FilterActivation = ENABLE;
+    can_filter_config.SlaveStartFilterBank = CAN_FILTER_BANKS_COUNT;
+    uint32_t i = 0u;
+    for (i = 0u; i < set.banks_count; i++) {
+        const CanFilterBank* bank = &set.banks[i];
+        const bool list = (bank->mode == CAN_FILTER_LIST_32) || (bank->mode == CAN_FILTER_LIST_16);
+        const bool scale_16 = (bank->mode == CAN_FILTER_MASK_16) || (bank->mode == CAN_FILTER_LIST_16);
+        can_filter_config.FilterBank = i;
+        can_filter_config.FilterMode = list ? CAN_FILTERMODE_IDLIST : CAN_FILTERMODE_IDMASK;
+        can_filter_config.FilterScale = scale_16 ? CAN_FILTERSCALE_16BIT : CAN_FILTERSCALE_32BIT;
+        if (scale_16) {
+            /* HAL puts the low halves into FR1 */
+            can_filter_config.FilterIdLow = bank->fr1 & 0xFFFFu;
+            can_filter_config.FilterMaskIdLow = bank->fr1 >> 16u;
+            can_filter_config.FilterIdHigh = bank->fr2 & 0xFFFFu;
+            can_filter_config.FilterMaskIdHigh = bank->fr2 >> 16u;
+        } else {
+            can_filter_config.FilterIdHigh = bank->fr1 >> 16u;
+            can_filter_config.FilterIdLow = bank->fr1 & 0xFFFFu;
+            can_filter_config.FilterMaskIdHigh = bank->fr2 >> 16u;
+            can_filter_config.FilterMaskIdLow = bank->fr2 & 0xFFFFu;
+        }
+        can_filter_config.FilterFIFOAssignment = ((i % 2u) == 0u) ? CAN_RX_FIFO0 : CAN_RX_FIFO1;
+        HAL_CAN_ConfigFilter(&hcan, &can_filter_config);
+    }
+}
+#else
+/* Accept all, even identifiers go to FIFO 0 and odd to FIFO 1. Standard and extended identifiers have the LSB
+ * in different places, so 4 banks are used */
+static void ConfigCanFilters(void) {
+    static const struct {
+        uint32_t id;
+        uint32_t mask;
+        uint32_t fifo;
+    } filters[] = {/* clang-format off */
+        {0u,                                        CAN_FILTER_IDE | CAN_FILTER_STID_LSB, CAN_RX_FIFO0},
+        {CAN_FILTER_STID_LSB,                       CAN_FILTER_IDE | CAN_FILTER_STID_LSB, CAN_RX_FIFO1},
+        {CAN_FILTER_IDE,                            CAN_FILTER_IDE | CAN_FILTER_EXID_LSB, CAN_RX_FIFO0},
+        {CAN_FILTER_IDE | CAN_FILTER_EXID_LSB,      CAN_FILTER_IDE | CAN_FILTER_EXID_LSB, CAN_RX_FIFO1}
+    }; /* clang-format on */
+
+    CAN_FilterTypeDef can_filter_config;
+    can_filter_config.FilterMode = CAN_FILTERMODE_IDMASK;
+    can_filter_config.FilterScale = CAN_FILTERSCALE_32BIT;
+    can_filter_config.FilterActivation = ENABLE;
+    can_filter_config.SlaveStartFilterBank = CAN_FILTER_BANKS_COUNT;
+    uint32_t i = 0u;
+    for (i = 0u; i < ARRAY_SIZE(filters); i++) {
+        can_filter_config.FilterBank = i;
+        can_filter_config.FilterIdHigh = filters[i].id >> 16u;
+        can_filter_config.FilterIdLow = filters[i].id & 0xFFFFu;
+        can_filter_config.FilterMaskIdHigh = filters[i].mask >> 16u;
+        can_filter_config.FilterMaskIdLow = filters[i].mask & 0xFFFFu;
+        can_filter_config.FilterFIFOAssignment = filters[i].fifo;
+        HAL_CAN_ConfigFilter(&hcan, &can_filter_config);
     }
 }
+#endif
+
+/* DLC 9..15 means 8 bytes */
+static uint32_t GetPayloadBytes(const CanFrameRecord* frame) {
+    if ((frame->flags & CAN_FRAME_RTR) != 0u) {
+        return 0u;
+    }
+    return (frame->dlc > 8u) ? 8u : frame->dlc;
+}
+
+/* Time is the frame time extended to 64 bit */
+static void ProcessFrame(const CanFrameRecord* frame, uint64_t time) {
+    const bool extended = (frame->flags & CAN_FRAME_EXTENDED) != 0u;
+    const bool rtr = (frame->flags & CAN_FRAME_RTR) != 0u;
+    const uint32_t bits = CanFrameLengthGet(frame->id, extended, rtr, frame->dlc, frame->data);
+    const uint32_t bus_time = bits * (CPU_FREQ / can_bitrate);
+    can_rx_busy_time += bus_time;
+#if CAN_FILTER_FOCUS != 0u
+    /* False positives of the hardware filters are counted and not analyzed */
+    if (!CanFilterIsWanted(can_filter_wanted, ARRAY_SIZE(can_filter_wanted), frame->id, extended)) {
+        can_filter_false_frames++;
+        can_rx_frames++;
+        return;
+    }
+#endif
 
-static volatile uint32_t prev_exti_time = 0;
-static volatile uint32_t can_active_time = 0;
-static volatile uint32_t can_inactive_time = 0;
-static const uint32_t can_playload_time = US_TO_CPU_TICKS(22);
+    const uint32_t payload_bytes = GetPayloadBytes(frame);
+    const uint32_t key = CanIdTableMakeKey(frame->id, extended);
+    const CanIdStats* entry = CanIdTableAdd(&can_id_table, key, time, payload_bytes, bits);
+    const uint32_t index = (uint32_t)(entry - can_id_table.entries);
+    CanTopUpdate(&can_top, &can_id_table, index);
+    CanScheduleAddFrame(&can_schedule, index, frame->time, entry->frames == 1u);
+    CanPayloadAdd(&can_payload, index, frame->data, payload_bytes, entry->frames == 1u);
+    CanSignalValuesAddFrame(&can_signal_values, &can_signals, key, frame->data, payload_bytes);
+#if CAN_TRIGGER != 0u
+    CanTriggerAddFrame(&can_trigger, frame, key);
+#endif
+#if CAN_J1939 != 0u
+    if (extended) {
+        CanJ1939AddFrame(&can_j1939, frame->id, frame->data, payload_bytes, time, bits);
+    }
+#endif
+#if CAN_CANOPEN != 0u
+    if (!extended) {
+        CanOpenAddFrame(&can_open, frame->id, frame->data, payload_bytes, time, bits);
+    }
+#endif
+#if CAN_ISOTP != 0u
+    CanIsoTpAddFrame(&can_isotp, key, frame->data, payload_bytes, time, bus_time);
+#endif
+
+    can_rx_frames++;
+}
+
+static void ReadFrames(void) {
+    /* Every frame received before now is in the ring, so the missing frames are not counted too early */
+    const uint64_t now64 = GetCpuCycles64();
+    const uint32_t now = (uint32_t)now64;
+    CanFrameRecord frames[CAN_FRAME_READ_BATCH];
+    size_t count = 0u;
+    do {
+        count = CanFrameRingRead(&can_frame_ring, frames, ARRAY_SIZE(frames));
+        /* The frames of the batch were received before this and less than 2^32 ticks ago */
+        const uint64_t read_time = GetCpuCycles64();
+        size_t i = 0u;
+        for (i = 0u; i < count; i++) {
+            ProcessFrame(&frames[i], ExtendCpuCycles(read_time, frames[i].time));
+        }
+    } while (count == ARRAY_SIZE(frames));
+    CanScheduleCheck(&can_schedule, now);
+#if CAN_J1939 != 0u
+    CanJ1939Check(&can_j1939, now64);
+#endif
+#if CAN_ISOTP != 0u
+    CanIsoTpCheck(&can_isotp, now64);
+#endif
+
+    CanMetricsData* data = CanMetricsBeginWrite(&can_metrics);
+    data->rx_read_frames = can_rx.frames;
+    data->rx_read_cycles = can_rx.cycles;
+    data->rx_frames = can_rx_frames;
+    data->rx_busy_time = can_rx_busy_time;
+#if CAN_FILTER_FOCUS != 0u
+    data->rx_wanted_frames = can_rx_frames - can_filter_false_frames;
+#endif
+    data->rx_overruns = can_frame_ring.overruns;
+    data->rx_fifo_overruns = can_rx.fifo_overruns[0] + can_rx.fifo_overruns[1];
+    data->rx_high_water = can_frame_ring.high_water;
+    data->rx_ids = can_id_table.count;
+    data->rx_id_evictions = can_id_table.evictions;
+    data->schedule_early = can_schedule.early;
+    data->schedule_late = can_schedule.late;
+    data->schedule_missing = can_schedule.missing;
+    CanMetricsEndWrite(&can_metrics);
+}
+
+static CanLoad can_load;
+static CanGlitch can_glitch;
+static CanStatus can_status;
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_CAPTURE
+static CanCapture can_capture;
+static CanDecoder can_decoder;
+static uint32_t can_decoder_cycles = 0u;
+static bool can_decoder_enabled = (CAN_BITRATE <= CAN_DECODER_MAX_BITRATE); /* The decoder keeps up */
+static CanGaps can_gaps;
+
+/* Called by the decoder */
+static void OnDecodedFrame(void* context, const CanDecodedFrame* frame) {
+    (void)context;
+
+    CanGapsAddFrame(&can_gaps, frame->start_time, frame->end_time);
+#if CAN_FILTER_FOCUS != 0u
+    /* bxCAN receives only these, so only these tell the frames it lost */
+    const bool extended = (frame->flags & CAN_DECODED_FRAME_EXTENDED) != 0u;
+    if (((frame->flags & CAN_DECODED_FRAME_CRC_ERROR) == 0u) &&
+        CanFilterIsWanted(can_filter_wanted, ARRAY_SIZE(can_filter_wanted), frame->id, extended)) {
+        can_filter_wanted_frames++;
+    }
+#endif
+}
+#endif
+#if CAN_AUTOBAUD != 0u
+static CanAutobaud can_autobaud;
+
+#define CAN_TIME_QUANTA (8u) /* SYNC + BS1 3TQ + BS2 4TQ, as in MX_CAN_Init */
+
+/* Reprogram the bxCAN bit timing and the measurement constants */
+static void SetCanBitrate(uint32_t bitrate) {
+    /* Check parameters */
+    assert(bitrate > 0u);
+
+    can_bitrate = bitrate;
+    const uint32_t bit_time = CPU_FREQ / bitrate;
+    CanLoadSetPayloadTime(&can_load, bit_time * CAN_PAYLOAD_BITS);
+    CanGlitchSetBitTime(&can_glitch, bit_time);
+    CanDecoderSetBitTime(&can_decoder, bit_time);
+    CanGapsSetBitTime(&can_gaps, bit_time);
+
+    /* The edges skipped while the decoder was off break the runs */
+    const bool decoder_enabled = (bitrate <= CAN_DECODER_MAX_BITRATE);
+    if (decoder_enabled && !can_decoder_enabled) {
+        CanDecoderResync(&can_decoder);
+        CanGapsResync(&can_gaps);
+    }
+    can_decoder_enabled = decoder_enabled;
+
+    const uint32_t prescaler = HAL_RCC_GetPCLK1Freq() / (bitrate * CAN_TIME_QUANTA);
+    (void)HAL_CAN_Stop(&hcan); /* Initialization mode, BTR is writable */
+    hcan.Instance->BTR = (hcan.Instance->BTR & ~CAN_BTR_BRP_Msk) | ((prescaler - 1u) << CAN_BTR_BRP_Pos);
+    (void)HAL_CAN_Start(&hcan);
+}
+#endif
+
+static void PublishLoad(CanMetricsData* data) {
+    data->edges = can_load.edges;
+    data->glitches = can_glitch.glitches;
+    data->active_time = can_load.active_time;
+    data->inactive_time = can_load.inactive_time;
+}
+
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_EXTI
+#define CAN_RX_EXTI_LINE GPIO_PIN_15
+
+static CanGovernor can_governor;
+static volatile bool can_governor_started = false;
+#endif
 
 void HAL_GPIO_EXTI_Callback(uint16_t gpio_pin_index) {
     (void)gpio_pin_index;
 
-    const uint32_t now = DWT->CYCCNT;
-    const uint32_t period = now - prev_exti_time;
-    prev_exti_time = now;
-    if (period < can_playload_time) {
-        can_active_time += period;
-    } else {
-        can_inactive_time += period - can_playload_time;
-        can_active_time += can_playload_time;
+    const uint32_t time = DWT->CYCCNT;
+    if (CanGlitchAcceptFalling(&can_glitch, time)) {
+        CanLoadAddEdge(&can_load, time);
     }
+    PublishLoad(CanMetricsBeginWrite(&can_metrics));
+    CanMetricsEndWrite(&can_metrics);
+
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_EXTI
+    if (can_governor_started &&
+        (CanGovernorAddIsr(&can_governor, time, (DWT->CYCCNT - time) + CAN_GOVERNOR_ISR_OVERHEAD) == false)) {
+        /* Till the next window. The masked time is not measured */
+        EXTI->IMR &= ~CAN_RX_EXTI_LINE;
+        CanLoadResync(&can_load);
+    }
+#endif
+}
+
+void SysTickIrqHandler(void) {
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_EXTI
+    if (can_governor_started) {
+        if (CanGovernorUpdate(&can_governor, DWT->CYCCNT)) {
+            EXTI->PR = CAN_RX_EXTI_LINE;
+            EXTI->IMR |= CAN_RX_EXTI_LINE;
+        }
+        CanMetricsBeginWrite(&can_metrics)->sampling_coverage = CanGovernorGetCoverage(&can_governor);
+        CanMetricsEndWrite(&can_metrics);
+    }
+#endif
+}
+
+/* Also samples the bxCAN error status */
+static void ReadEdges(void) {
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_CAPTURE
+    CanEdge edges[CAN_CAPTURE_READ_BATCH];
+    for (;;) {
+        size_t count = CanCaptureRead(&can_capture, edges, ARRAY_SIZE(edges));
+        if (CanCaptureTakeLost(&can_capture)) {
+            CanGlitchResync(&can_glitch);
+            CanLoadResync(&can_load);
+            CanDecoderResync(&can_decoder);
+            CanGapsResync(&can_gaps);
+#if CAN_AUTOBAUD != 0u
+            CanAutobaudResync(&can_autobaud);
+#endif
+        }
+        if (count == 0u) {
+            break;
+        }
+#if CAN_AUTOBAUD != 0u
+        /* Before the filter, it depends on the bit rate. Detection has its own filter for the fastest rate */
+        CanAutobaudAddEdges(&can_autobaud, edges, count);
+#endif
+        count = CanGlitchFilter(&can_glitch, edges, count);
+        CanLoadAddEdges(&can_load, edges, count);
+        if (can_decoder_enabled) {
+            const uint32_t decoder_start = GetCpuCycles();
+            CanDecoderAddEdges(&can_decoder, edges, count);
+            can_decoder_cycles += GetCpuCycles() - decoder_start;
+        }
+    }
+#if CAN_AUTOBAUD != 0u
+    const uint32_t detected_bitrate = CanAutobaudTakeResult(&can_autobaud);
+    if ((detected_bitrate != 0u) && (detected_bitrate != can_bitrate)) {
+        SetCanBitrate(detected_bitrate);
+    }
+#endif
+    if (can_decoder_enabled) {
+        CanDecoderFlush(&can_decoder, CanGlitchGetTime(&can_glitch, CanCaptureGetTime(&can_capture)));
+    }
+#endif
+    CanStatusSample(&can_status);
+#if (CAN_TRIGGER != 0u) && (CAN_TRIGGER_ON_ERROR != 0u)
+    uint32_t trigger_errors = can_status.errors;
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_CAPTURE
+    trigger_errors += can_decoder.error_frames;
+#endif
+    if (trigger_errors != trigger_errors_prev) {
+        trigger_errors_prev = trigger_errors;
+        CanTriggerFire(&can_trigger, CAN_TRIGGER_CAUSE_ERROR, GetCpuCycles());
+    }
+#endif
+
+    CanMetricsData* data = CanMetricsBeginWrite(&can_metrics);
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_CAPTURE
+    PublishLoad(data);
+    data->capture_overruns = can_capture.overruns;
+    data->frames = can_decoder.frames;
+    data->busy_time = can_decoder.busy_time;
+    data->decoder_cycles = can_decoder_cycles;
+#if CAN_FILTER_FOCUS != 0u
+    data->wanted_frames = can_filter_wanted_frames;
+#endif
+    data->stuff_errors = can_decoder.stuff_errors;
+    data->form_errors = can_decoder.form_errors;
+    data->crc_errors = can_decoder.crc_errors;
+    data->bursts = can_gaps.bursts;
+    data->max_burst_length = can_gaps.max_burst_length;
+    data->error_frames = can_decoder.error_frames;
+    data->error_time = can_decoder.error_time;
+#endif
+    data->bus_errors = can_status.errors;
+    data->tec = can_status.tec;
+    data->rec = can_status.rec;
+    data->error_state = can_status.flags;
+    CanMetricsEndWrite(&can_metrics);
+}
+
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+static CanGated can_gated;
+#endif
+
+void Tim2IrqHandler(void) {
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+    CanGatedIrqHandler(&can_gated);
+#endif
+}
+
+/* The capture buffer and the frame ring are drained while waiting */
+static void WaitAndReadEdges(uint32_t delay_ms) {
+    const uint32_t start = HAL_GetTick();
+    do {
+        ReadEdges();
+        ReadFrames();
+    } while ((HAL_GetTick() - start) < delay_ms);
 }
 
 static const Mt12232aConfig mt12232a_config = {/* clang-format off */
@@ -58,15 +525,658 @@ static const Mt12232aConfig mt12232a_config = {/* clang-format off */
 #define TEXT_WIDTH (16u + 16u)
 #define GRAPH_WIDTH (MT12232A_WIDTH - TEXT_WIDTH)
 
+#define GRAPH_HEIGHT (32u)
+
+static CanHistory can_history;
+
+/* Points of a column of value of total, rounded up so any non-zero value is visible */
+static uint32_t GetColumnHeight(uint32_t height, uint32_t value, uint32_t total) {
+    const uint32_t points = (total == 0u) ? 0u : (uint32_t)((((uint64_t)value * height) + total - 1u) / total);
+    return (points < height) ? points : height;
+}
+
+/* Column from the bottom of a band, value of total. Y and height are multiples of MT12232A_POINTS_IN_BYTE */
+static void DrawColumn(uint8_t* screen, uint32_t x, uint32_t y, uint32_t height, uint32_t value, uint32_t total) {
+    const uint32_t value32 = GetColumnHeight(height, value, total);
+    const uint32_t mask = (uint32_t)((((uint64_t)1u << value32) - 1u) << (height - value32));
+    size_t screen_addr = ((y / MT12232A_POINTS_IN_BYTE) * MT12232A_WIDTH) + x;
+    uint32_t i = 0u;
+    for (i = 0u; i < (height / MT12232A_POINTS_IN_BYTE); i++) {
+        screen[screen_addr] = (uint8_t)(mask >> (i * MT12232A_POINTS_IN_BYTE));
+        screen_addr += MT12232A_WIDTH;
+    }
+}
+
+/* Column of the graph area, value of total */
+static void DrawBar(uint8_t* screen, uint32_t x, uint32_t value, uint32_t total) {
+    DrawColumn(screen, GRAPH_X + x, GRAPH_Y, GRAPH_HEIGHT, value, total);
+}
+
+/* Row of the graph area at the top of the bar of value of total, the bottom row for 0 */
+static uint32_t GetBarTop(uint32_t value, uint32_t total) {
+    const uint32_t points = GetColumnHeight(GRAPH_HEIGHT, value, total);
+    return GRAPH_HEIGHT - ((points != 0u) ? points : 1u);
+}
+
+/* Point of the graph area, inverted so it shows over the bars */
+static void InvertPoint(uint8_t* screen, uint32_t x, uint32_t y) {
+    const uint32_t row = GRAPH_Y + y;
+    screen[((row / MT12232A_POINTS_IN_BYTE) * MT12232A_WIDTH) + GRAPH_X + x] ^=
+        (uint8_t)(1u << (row % MT12232A_POINTS_IN_BYTE));
+}
+
+#define PEAK_SECONDS (10u)
+#define PEAK_DOTS_STEP (3u) /* Points between the dots of the peak line */
+
+/* The newest history sample is the rightmost column, a dotted line marks the peak of the last seconds */
+static void DrawGraph(uint8_t* screen) {
+    uint32_t x = 0u;
+    for (x = 0u; x < GRAPH_WIDTH; x++) {
+        CanHistoryBucket bucket = {0};
+        (void)CanHistoryGet(&can_history, CAN_HISTORY_SAMPLES, GRAPH_WIDTH - 1u - x, &bucket);
+        DrawBar(screen, x, bucket.avg, 100u);
+    }
+    CanHistoryBucket peak = {0};
+    if (CanHistorySummary(&can_history, CAN_HISTORY_SAMPLES, 0u, PEAK_SECONDS * CAN_HISTORY_SAMPLES_PER_SECOND,
+                          &peak) &&
+        (peak.max != 0u)) {
+        const uint32_t y = GetBarTop(peak.max, 100u);
+        for (x = 0u; x < GRAPH_WIDTH; x += PEAK_DOTS_STEP) {
+            InvertPoint(screen, x, y);
+        }
+    }
+}
+
+#define TREND_SECONDS_PER_COLUMN ((CAN_HISTORY_SECONDS_SIZE + GRAPH_WIDTH - 1u) / GRAPH_WIDTH)
+#define TREND_MINUTES_PER_COLUMN ((CAN_HISTORY_MINUTES_SIZE + GRAPH_WIDTH - 1u) / GRAPH_WIDTH)
+#define TREND_TEXT_WIDTH (3u * 8u) /* "24H" */
+
+/* Average load of each column with a point at its maximum, the newest column is the rightmost. The seconds
+ * level first, then the minutes level */
+static void DrawTrendPage(GraphicsContext* context, uint32_t page_update) {
+    const bool seconds = page_update < (CAN_DISPLAY_PAGE_UPDATES / 2u);
+    const uint32_t level = seconds ? CAN_HISTORY_SECONDS : CAN_HISTORY_MINUTES;
+    const uint32_t per_column = seconds ? TREND_SECONDS_PER_COLUMN : TREND_MINUTES_PER_COLUMN;
+    uint32_t x = 0u;
+    for (x = 0u; x < GRAPH_WIDTH; x++) {
+        CanHistoryBucket bucket = {0};
+        const bool valid =
+            CanHistorySummary(&can_history, level, (GRAPH_WIDTH - 1u - x) * per_column, per_column, &bucket);
+        DrawBar(context->buffer, x, bucket.avg, 100u);
+        if (valid && (bucket.max > bucket.avg)) {
+            InvertPoint(context->buffer, x, GetBarTop(bucket.max, 100u));
+        }
+    }
+
+    /* Span of the graph */
+    char text[8];
+    if (seconds) {
+        (void)snprintf(text, sizeof(text), "%uM", (unsigned)(CAN_HISTORY_SECONDS_SIZE / 60u));
+    } else {
+        (void)snprintf(text, sizeof(text), "%uH", (unsigned)(CAN_HISTORY_MINUTES_SIZE / 60u));
+    }
+    DrawText(context, &font_8x16, 0, 0, TREND_TEXT_WIDTH, 16, text);
+}
+
+typedef enum {
+    DISPLAY_PAGE_LOAD,
+    DISPLAY_PAGE_TREND,
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+    DISPLAY_PAGE_GAPS,
+#endif
+    DISPLAY_PAGE_TOP,
+    DISPLAY_PAGE_PAYLOAD,
+    DISPLAY_PAGE_SIGNALS,
+#if CAN_FILTER_FOCUS != 0u
+    DISPLAY_PAGE_FILTER,
+#endif
+#if CAN_TRIGGER != 0u
+    DISPLAY_PAGE_TRIGGER,
+#endif
+#if CAN_J1939 != 0u
+    DISPLAY_PAGE_J1939,
+#endif
+#if CAN_ISOTP != 0u
+    DISPLAY_PAGE_ISOTP,
+#endif
+#if CAN_CANOPEN != 0u
+    DISPLAY_PAGE_CANOPEN,
+#endif
+    DISPLAY_PAGES_COUNT
+} DisplayPage;
+
+#define SCHEDULE_TEXT_WIDTH (5u * 8u) /* "T99/s" */
+#define HEARTBEAT_TEXT_WIDTH (5u * 8u) /* "H127!" */
+
+#define TOP_ROWS (2u) /* Lines of font_8x16 */
+#define TOP_SCREENS ((CAN_TOP_SIZE + TOP_ROWS - 1u) / TOP_ROWS)
+
+/* The first rank of the screen, the top pages scroll through the top during the page time */
+static uint32_t GetTopFirstRank(uint32_t page_update) {
+    return ((page_update * TOP_SCREENS) / CAN_DISPLAY_PAGE_UPDATES) * TOP_ROWS;
+}
+
+/* Identifier and percent of the bus time per line */
+static void DrawTopPage(GraphicsContext* context, uint32_t page_update) {
+    const uint32_t first = GetTopFirstRank(page_update);
+    uint16_t indexes[CAN_TOP_SIZE];
+    const uint32_t count = CanTopGet(&can_top, &can_id_table, indexes, ARRAY_SIZE(indexes));
+    uint32_t row = 0u;
+    for (row = 0u; row < TOP_ROWS; row++) {
+        char text[16] = {};
+        const uint32_t rank = first + row;
+        if (rank < count) {
+            const CanIdStats* entry = &can_id_table.entries[indexes[rank]];
+            const uint32_t total = can_id_table.bus_bits_total;
+            const uint32_t percent =
+                (total == 0u) ? 0u : (uint32_t)(((uint64_t)entry->bus_bits * 100u) / total);
+            (void)snprintf(text, sizeof(text), "%8lX%3u", (unsigned long)(entry->key & ~CAN_ID_TABLE_EXTENDED),
+                           (unsigned)percent);
+        }
+        DrawText(context, &font_8x16, 0, row * 16u, GRAPH_WIDTH, 16, text);
+    }
+}
+
+#define PAYLOAD_BAR_WIDTH (3u) /* 2 points and a space */
+#define PAYLOAD_BARS_X (GRAPH_WIDTH - (8u * PAYLOAD_BAR_WIDTH))
+
+/* Identifier and a column per payload byte, as high as the number of its bits that change */
+static void DrawPayloadPage(GraphicsContext* context, uint32_t page_update) {
+    const uint32_t first = GetTopFirstRank(page_update);
+    uint16_t indexes[CAN_TOP_SIZE];
+    const uint32_t count = CanTopGet(&can_top, &can_id_table, indexes, ARRAY_SIZE(indexes));
+    uint32_t row = 0u;
+    for (row = 0u; row < TOP_ROWS; row++) {
+        char text[16] = {};
+        const uint32_t rank = first + row;
+        uint32_t byte = 0u;
+        for (byte = 0u; byte < 8u; byte++) {
+            const uint32_t activity =
+                (rank < count) ? CanPayloadGetByteActivity(&can_payload, indexes[rank], byte) : 0u;
+            const uint32_t x = PAYLOAD_BARS_X + (byte * PAYLOAD_BAR_WIDTH);
+            DrawColumn(context->buffer, x, row * 16u, 16u, activity, 8u);
+            DrawColumn(context->buffer, x + 1u, row * 16u, 16u, activity, 8u);
+            DrawColumn(context->buffer, x + 2u, row * 16u, 16u, 0u, 8u);
+        }
+        if (rank < count) {
+            const CanIdStats* entry = &can_id_table.entries[indexes[rank]];
+            (void)snprintf(text, sizeof(text), "%8lX", (unsigned long)(entry->key & ~CAN_ID_TABLE_EXTENDED));
+        }
+        DrawText(context, &font_8x16, 0, row * 16u, PAYLOAD_BARS_X, 16, text);
+    }
+}
+
+#define SIGNAL_TEXT_SIZE (12u) /* A line of font_8x16 */
+
+/* Value in units of 10^-decimals as "-1.23", "12.3" or "123", the rest of the decimals is truncated */
+static void FormatSignalValue(const CanSignal* signal, int64_t value, char text[], size_t size) {
+    static const uint32_t powers[] = {1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u};
+    assert(signal->decimals < ARRAY_SIZE(powers));
+    const uint64_t magnitude = (value < 0) ? (uint64_t)-value : (uint64_t)value;
+    const uint64_t integer = magnitude / powers[signal->decimals];
+    const char* sign = (value < 0) ? "-" : "";
+    if (integer > 99999999u) {
+        (void)snprintf(text, size, "%sOVER", sign);
+    } else if ((signal->decimals == 0u) || (integer >= 100u)) {
+        (void)snprintf(text, size, "%s%lu%s", sign, (unsigned long)integer, signal->unit);
+    } else {
+        uint32_t shown = (integer >= 100u) ? 0u : ((integer >= 10u) ? 1u : 2u);
+        shown = (signal->decimals < shown) ? signal->decimals : shown;
+        const uint32_t fraction = (uint32_t)(magnitude % powers[signal->decimals]) / powers[signal->decimals - shown];
+        (void)snprintf(text, size, "%s%lu.%0*lu%s", sign, (unsigned long)integer, (int)shown, (unsigned long)fraction,
+                       signal->unit);
+    }
+}
+
+#define SIGNAL_ROWS (2u) /* Lines of font_8x16 */
+
+/* The label and the last value of the signals compiled from the DBC file, scrolled during the page time */
+static void DrawSignalsPage(GraphicsContext* context, uint32_t page_update) {
+    const uint32_t count =
+        (can_signals.signals_count < CAN_SIGNAL_VALUES_SIZE) ? can_signals.signals_count : CAN_SIGNAL_VALUES_SIZE;
+    const uint32_t screens = (count + SIGNAL_ROWS - 1u) / SIGNAL_ROWS;
+    const uint32_t first = ((page_update * screens) / CAN_DISPLAY_PAGE_UPDATES) * SIGNAL_ROWS;
+    uint32_t row = 0u;
+    for (row = 0u; row < SIGNAL_ROWS; row++) {
+        char text[SIGNAL_TEXT_SIZE] = {};
+        const uint32_t i = first + row;
+        if (i < count) {
+            const CanSignal* signal = &can_signals.signals[i];
+            char value[SIGNAL_TEXT_SIZE] = "-";
+            if ((can_signal_values.valid & (1u << i)) != 0u) {
+                FormatSignalValue(signal, can_signal_values.values[i], value, sizeof(value));
+            }
+            /* The value is right aligned, the label takes the rest */
+            const int label_width = (int)(sizeof(text) - 1u - strlen(value));
+            (void)snprintf(text, sizeof(text), "%-*.*s%s", label_width, (label_width > 0) ? (label_width - 1) : 0,
+                           signal->name, value);
+        } else if ((i == 0u) && (count == 0u)) {
+            (void)snprintf(text, sizeof(text), "NO SIGNALS");
+        } else {
+            /* Empty line */
+        }
+        DrawText(context, &font_8x16, 0, row * 16u, GRAPH_WIDTH, 16, text);
+    }
+}
+
+#if CAN_FILTER_FOCUS != 0u
+/* The banks used and the false positives in percent of the identifiers they pass,
+ * then in percent of the received frames */
+static void DrawFilterPage(GraphicsContext* context) {
+    char text[2][16] = {};
+    (void)snprintf(text[0], sizeof(text[0]), "%uB FP%u%%", (unsigned)can_filter_banks,
+                   (unsigned)can_filter_false_percent);
+    const uint32_t frames = can_rx_frames;
+    (void)snprintf(text[1], sizeof(text[1]), "RX FP%u%%",
+                   (unsigned)((frames == 0u) ? 0u : (uint32_t)(((uint64_t)can_filter_false_frames * 100u) / frames)));
+    DrawText(context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, text[0]);
+    DrawText(context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, text[1]);
+}
+#endif
+
+#if CAN_TRIGGER != 0u
+#define TRIGGER_FRAMES_PER_VISIT (CAN_DISPLAY_PAGE_UPDATES / CAN_TRIGGER_FRAME_UPDATES)
+#define TRIGGER_BYTES_PER_LINE (5u)
+
+/* The armed conditions or the post trigger frames being collected. When the capture is done,
+ * a captured frame per CAN_TRIGGER_FRAME_UPDATES, the next visit of the page continues from the next frame.
+ * The offset from the event and the identifier, then the payload in two parts */
+static void DrawTriggerPage(GraphicsContext* context, uint32_t page_visit, uint32_t page_update) {
+    char text[2][16] = {};
+    if (can_trigger.state == CAN_TRIGGER_ARMED) {
+        (void)snprintf(text[0], sizeof(text[0]), "ARMED");
+        (void)snprintf(text[1], sizeof(text[1]), "%s%s", (CAN_TRIGGER_ON_ERROR != 0u) ? "E " : "",
+                       ((CAN_TRIGGER_KEY_MASK != 0u) || (CAN_TRIGGER_DATA_MASK != 0u)) ? "F " : "");
+        if (CAN_TRIGGER_LOAD_PERCENT != 0u) {
+            const size_t length = strlen(text[1]);
+            (void)snprintf(&text[1][length], sizeof(text[1]) - length, "L%u%%", (unsigned)CAN_TRIGGER_LOAD_PERCENT);
+        }
+    } else if (can_trigger.state == CAN_TRIGGER_FIRED) {
+        (void)snprintf(text[0], sizeof(text[0]), "FIRED");
+        (void)snprintf(text[1], sizeof(text[1]), "%u/%u", (unsigned)(can_trigger.written - can_trigger.position),
+                       (unsigned)CAN_TRIGGER_POST_FRAMES);
+    } else if (CanTriggerGetCount(&can_trigger) != 0u) {
+        const uint32_t index = ((page_visit * TRIGGER_FRAMES_PER_VISIT) + (page_update / CAN_TRIGGER_FRAME_UPDATES)) %
+                               CanTriggerGetCount(&can_trigger);
+        int32_t offset = 0;
+        const CanFrameRecord* frame = CanTriggerGetFrame(&can_trigger, index, &offset);
+        (void)snprintf(text[0], sizeof(text[0]), "%+ld %lX", (long)offset, (unsigned long)frame->id);
+        if ((frame->flags & CAN_FRAME_RTR) != 0u) {
+            (void)snprintf(text[1], sizeof(text[1]), "RTR%u", (unsigned)frame->dlc);
+        } else {
+            const uint32_t size = (frame->dlc < CAN_FRAME_MAX_DATA) ? frame->dlc : CAN_FRAME_MAX_DATA;
+            const bool second_part = (page_update % CAN_TRIGGER_FRAME_UPDATES) >= (CAN_TRIGGER_FRAME_UPDATES / 2u);
+            const uint32_t first = second_part ? TRIGGER_BYTES_PER_LINE : 0u;
+            uint32_t i = 0u;
+            for (i = first; (i < size) && (i < (first + TRIGGER_BYTES_PER_LINE)); i++) {
+                (void)snprintf(&text[1][(i - first) * 2u], 3u, "%02X", (unsigned)frame->data[i]);
+            }
+        }
+    } else {
+        (void)snprintf(text[0], sizeof(text[0]), "NO FRAMES");
+    }
+    DrawText(context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, text[0]);
+    DrawText(context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, text[1]);
+}
+#endif
+
+#if CAN_J1939 != 0u
+static uint32_t GetJ1939Percent(const CanJ1939Counter* counter) {
+    const uint32_t total = can_j1939.bus_bits_total;
+    return ((counter == NULL) || (total == 0u)) ? 0u : (uint32_t)(((uint64_t)counter->bus_bits * 100u) / total);
+}
+
+/* Frames of a top counter at the previous page update */
+typedef struct {
+    uint32_t key;
+    uint32_t frames;
+    uint64_t time;
+} J1939RatePrev;
+
+static J1939RatePrev j1939_pgn_prev = {CAN_J1939_EMPTY, 0u, 0u};
+static J1939RatePrev j1939_source_prev = {CAN_J1939_EMPTY, 0u, 0u};
+
+/* Frames per second of the counter since the previous page update, 0 when the top key changed or the counters were
+ * halved */
+static uint32_t GetJ1939Rate(J1939RatePrev* prev, const CanJ1939Counter* counter, uint64_t now) {
+    uint32_t rate = 0u;
+    if (counter == NULL) {
+        prev->key = CAN_J1939_EMPTY;
+        return rate;
+    }
+    if ((counter->key == prev->key) && (counter->frames >= prev->frames) && (now > prev->time)) {
+        rate = (uint32_t)(((uint64_t)(counter->frames - prev->frames) * CPU_FREQ) / (now - prev->time));
+    }
+    prev->key = counter->key;
+    prev->frames = counter->frames;
+    prev->time = now;
+    return rate;
+}
+
+#define J1939_PAGE_PARTS (4u)
+
+/* The PGN and the source address with the largest share of the bus time and their frames per second,
+ * then the transport protocol transfers with the PGN of the last one, its throughput and duration */
+static void DrawJ1939Page(GraphicsContext* context, uint32_t page_update) {
+    char text[2][16] = {};
+    const uint32_t part = (page_update * J1939_PAGE_PARTS) / CAN_DISPLAY_PAGE_UPDATES;
+    const uint64_t now = GetCpuCycles64();
+    const CanJ1939Counter* pgn = CanJ1939GetTop(can_j1939.pgns, ARRAY_SIZE(can_j1939.pgns));
+    const CanJ1939Counter* source = CanJ1939GetTop(can_j1939.sources, ARRAY_SIZE(can_j1939.sources));
+    const uint32_t pgn_rate = GetJ1939Rate(&j1939_pgn_prev, pgn, now);
+    const uint32_t source_rate = GetJ1939Rate(&j1939_source_prev, source, now);
+    if (part == 0u) {
+        if (pgn != NULL) {
+            (void)snprintf(text[0], sizeof(text[0]), "P%05lX%3u%%", (unsigned long)pgn->key,
+                           (unsigned)GetJ1939Percent(pgn));
+            (void)snprintf(text[1], sizeof(text[1]), "%u/s", (unsigned)pgn_rate);
+        }
+    } else if (part == 1u) {
+        if (source != NULL) {
+            (void)snprintf(text[0], sizeof(text[0]), "SA%02X%3u%%", (unsigned)source->key,
+                           (unsigned)GetJ1939Percent(source));
+            (void)snprintf(text[1], sizeof(text[1]), "%u/s", (unsigned)source_rate);
+        }
+    } else if (part == 2u) {
+        (void)snprintf(text[0], sizeof(text[0]), "TP%u A%u", (unsigned)can_j1939.messages,
+                       (unsigned)can_j1939.aborts);
+        if (can_j1939.messages != 0u) {
+            (void)snprintf(text[1], sizeof(text[1]), "P%05lX", (unsigned long)can_j1939.last_pgn);
+        }
+    } else {
+        const uint64_t duration = can_j1939.last_duration;
+        if (duration != 0u) {
+            (void)snprintf(text[0], sizeof(text[0]), "%uB/s",
+                           (unsigned)(((uint64_t)can_j1939.last_size * CPU_FREQ) / duration));
+            (void)snprintf(text[1], sizeof(text[1]), "%u.%us", (unsigned)(duration / CPU_FREQ),
+                           (unsigned)((duration % CPU_FREQ) / (CPU_FREQ / 10u)));
+        }
+    }
+    DrawText(context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, text[0]);
+    DrawText(context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, text[1]);
+}
+#endif
+
+#if CAN_ISOTP != 0u
+static uint32_t GetIsoTpPercent(uint32_t part, uint64_t duration) {
+    return (duration == 0u) ? 0u : (uint32_t)(((uint64_t)part * 100u) / duration);
+}
+
+#define ISOTP_PAGE_PARTS (3u)
+
+/* The active ISO-TP transfer with the most bytes, or the last completed one, marked with a star while active:
+ * throughput, duration and progress, then the flow control wait and the own bus time in percent of the duration.
+ * A high wait is the receiver, a high bus time is the bus, the rest is the sender with STmin. Then the gaps of the
+ * pair: the ECU before a response and the tester before the next request */
+static void DrawIsoTpPage(GraphicsContext* context, uint32_t page_update) {
+    char text[2][16] = {};
+    const uint32_t part = (page_update * ISOTP_PAGE_PARTS) / CAN_DISPLAY_PAGE_UPDATES;
+    const CanIsoTpSession* pair = CanIsoTpGetActive(&can_isotp);
+    const bool active = (pair != NULL) && (pair->state != (uint8_t)CAN_ISOTP_SESSION_IDLE);
+    const CanIsoTpSession* last = (can_isotp.completed != 0u) ? &can_isotp.last : NULL;
+    const CanIsoTpSession* session = active ? pair : last;
+    if (part == (ISOTP_PAGE_PARTS - 1u)) {
+        session = (pair != NULL) ? pair : last;
+    }
+    if (session == NULL) {
+        (void)snprintf(text[0], sizeof(text[0]), "TP%u A%u", (unsigned)can_isotp.completed,
+                       (unsigned)can_isotp.aborts);
+    } else if (part == (ISOTP_PAGE_PARTS - 1u)) {
+        (void)snprintf(text[0], sizeof(text[0]), "E%ums", (unsigned)(session->ecu_time / (CPU_FREQ / 1000u)));
+        (void)snprintf(text[1], sizeof(text[1]), "T%ums", (unsigned)(session->tester_time / (CPU_FREQ / 1000u)));
+    } else {
+        const uint64_t duration = (active ? GetCpuCycles64() : session->last_time) - session->start_time;
+        if (part == 0u) {
+            const uint32_t throughput =
+                (duration == 0u) ? 0u : (uint32_t)(((uint64_t)session->received * CPU_FREQ) / duration);
+            (void)snprintf(text[0], sizeof(text[0]), "%uB/s%s", (unsigned)throughput, active ? "*" : "");
+            (void)snprintf(text[1], sizeof(text[1]), "%u.%us %u%%", (unsigned)(duration / CPU_FREQ),
+                           (unsigned)((duration % CPU_FREQ) / (CPU_FREQ / 10u)),
+                           (unsigned)GetIsoTpPercent(session->received, session->size));
+        } else {
+            (void)snprintf(text[0], sizeof(text[0]), "W%u%% B%u%%",
+                           (unsigned)GetIsoTpPercent(session->fc_wait_time, duration),
+                           (unsigned)GetIsoTpPercent(session->bus_time, duration));
+            (void)snprintf(text[1], sizeof(text[1]), "ST%u BS%u", (unsigned)session->st_min,
+                           (unsigned)session->block_size);
+        }
+    }
+    DrawText(context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, text[0]);
+    DrawText(context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, text[1]);
+}
+#endif
+
+#if CAN_CANOPEN != 0u
+static uint32_t GetCanOpenPercent(CanOpenClass cls) {
+    const uint32_t total = can_open.bus_bits_total;
+    return (total == 0u) ? 0u : (uint32_t)(((uint64_t)can_open.bus_bits[cls] * 100u) / total);
+}
+
+/* Shares of the bus time by class: PDO, SDO, EMCY, then SYNC, NMT and the rest.
+ * Then the nodes with a heartbeat, the operational ones, the lost ones and the heartbeats missed */
+static void DrawCanOpenPage(GraphicsContext* context, uint32_t page_update) {
+    char text[2][16] = {};
+    if (page_update < (CAN_DISPLAY_PAGE_UPDATES / 2u)) {
+        (void)snprintf(text[0], sizeof(text[0]), "P%u S%u E%u", (unsigned)GetCanOpenPercent(CAN_OPEN_PDO),
+                       (unsigned)GetCanOpenPercent(CAN_OPEN_SDO), (unsigned)GetCanOpenPercent(CAN_OPEN_EMCY));
+        const uint32_t other = GetCanOpenPercent(CAN_OPEN_OTHER) + GetCanOpenPercent(CAN_OPEN_TIME) +
+                               GetCanOpenPercent(CAN_OPEN_HEARTBEAT) + GetCanOpenPercent(CAN_OPEN_LSS);
+        (void)snprintf(text[1], sizeof(text[1]), "Y%u N%u O%u", (unsigned)GetCanOpenPercent(CAN_OPEN_SYNC),
+                       (unsigned)GetCanOpenPercent(CAN_OPEN_NMT), (unsigned)other);
+    } else {
+        uint32_t nodes = 0u;
+        uint32_t operational = 0u;
+        uint32_t lost = 0u;
+        uint32_t i = 0u;
+        for (i = 0u; i < CAN_OPEN_NODES_COUNT; i++) {
+            const CanOpenNode* node = &can_open.nodes[i];
+            if (node->state != CAN_OPEN_STATE_UNKNOWN) {
+                nodes++;
+                operational += (node->state == CAN_OPEN_STATE_OPERATIONAL) ? 1u : 0u;
+                lost += ((node->flags & CAN_OPEN_NODE_LOST) != 0u) ? 1u : 0u;
+            }
+        }
+        (void)snprintf(text[0], sizeof(text[0]), "N%u OP%u", (unsigned)nodes, (unsigned)operational);
+        (void)snprintf(text[1], sizeof(text[1]), "HB%u M%u", (unsigned)lost, (unsigned)can_open.heartbeat_misses);
+    }
+    DrawText(context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, text[0]);
+    DrawText(context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, text[1]);
+}
+#endif
+
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+#define GAPS_BAR_WIDTH (3u) /* 2 points and a space */
+#define GAPS_TEXT_X (CAN_GAPS_BINS_COUNT * GAPS_BAR_WIDTH)
+
+/* Gap histogram relative to the largest bin, the longest burst and the number of bursts,
+ * then the CPU ticks of the decoder per bit instead of the number of bursts */
+static void DrawGapsPage(GraphicsContext* context, const CanMetricsData* metrics, uint32_t page_update,
+                         uint32_t decoder_cost) {
+    uint32_t max_count = 0u;
+    uint32_t i = 0u;
+    for (i = 0u; i < CAN_GAPS_BINS_COUNT; i++) {
+        if (can_gaps.bins[i] > max_count) {
+            max_count = can_gaps.bins[i];
+        }
+    }
+    for (i = 0u; i < CAN_GAPS_BINS_COUNT; i++) {
+        DrawBar(context->buffer, i * GAPS_BAR_WIDTH, can_gaps.bins[i], max_count);
+        DrawBar(context->buffer, (i * GAPS_BAR_WIDTH) + 1u, can_gaps.bins[i], max_count);
+        DrawBar(context->buffer, (i * GAPS_BAR_WIDTH) + 2u, 0u, max_count);
+    }
+
+    char text[8];
+    (void)snprintf(text, sizeof(text), "B%u", (unsigned)metrics->max_burst_length);
+    DrawText(context, &font_8x16, GAPS_TEXT_X, 0, GRAPH_WIDTH - GAPS_TEXT_X, 16, text);
+    if (page_update < (CAN_DISPLAY_PAGE_UPDATES / 2u)) {
+        (void)snprintf(text, sizeof(text), "N%u", (unsigned)metrics->bursts);
+    } else {
+        (void)snprintf(text, sizeof(text), "C%u", (unsigned)decoder_cost);
+    }
+    DrawText(context, &font_8x16, GAPS_TEXT_X, 16, GRAPH_WIDTH - GAPS_TEXT_X, 16, text);
+}
+#endif
+
+static uint32_t CalcPercent(uint32_t part, uint32_t total) {
+    if (total == 0u) {
+        return 0u;
+    }
+    return ((part * 100u) + total - 1u) / total;
+}
+
 static uint32_t can_active_time_prev = 0;
 static uint32_t can_inactive_time_prev = 0;
 
+static uint32_t GetEdgesLoad(const CanMetricsData* metrics) {
+    const uint32_t can_active_time_now = metrics->active_time;
+    const uint32_t can_inactive_time_now = metrics->inactive_time;
+    const uint32_t can_active_time_period = can_active_time_now - can_active_time_prev;
+    const uint32_t can_inactive_time_period = can_inactive_time_now - can_inactive_time_prev;
+    can_active_time_prev = can_active_time_now;
+    can_inactive_time_prev = can_inactive_time_now;
+    return CalcPercent(can_active_time_period, can_active_time_period + can_inactive_time_period);
+}
+
+static uint32_t schedule_anomalies_prev = 0;
+static uint32_t schedule_cpu_cycles_prev = 0;
+
+/* Early, late and missing frames of the periodic identifiers per second */
+static uint32_t GetScheduleAlarm(const CanMetricsData* metrics) {
+    const uint32_t anomalies = metrics->schedule_early + metrics->schedule_late + metrics->schedule_missing;
+    const uint32_t cpu_cycles_now = GetCpuCycles();
+    const uint32_t anomalies_period = anomalies - schedule_anomalies_prev;
+    const uint32_t cpu_cycles_period = cpu_cycles_now - schedule_cpu_cycles_prev;
+    schedule_anomalies_prev = anomalies;
+    schedule_cpu_cycles_prev = cpu_cycles_now;
+    return (cpu_cycles_period == 0u) ? 0u : (uint32_t)(((uint64_t)anomalies_period * CPU_FREQ) / cpu_cycles_period);
+}
+
+static uint32_t can_rx_read_cycles_prev = 0;
+static uint32_t can_rx_read_frames_prev = 0;
+
+/* CPU ticks of the receive interrupt per frame, HAL or the fast path by CAN_RX_FAST_PATH. 0 without frames */
+static uint32_t GetRxCost(const CanMetricsData* metrics) {
+    const uint32_t cycles_period = metrics->rx_read_cycles - can_rx_read_cycles_prev;
+    const uint32_t frames_period = metrics->rx_read_frames - can_rx_read_frames_prev;
+    can_rx_read_cycles_prev = metrics->rx_read_cycles;
+    can_rx_read_frames_prev = metrics->rx_read_frames;
+    return (frames_period == 0u) ? 0u : (cycles_period / frames_period);
+}
+
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+static uint32_t can_busy_time_prev = 0;
+static uint32_t frames_cpu_cycles_prev = 0;
+
+/* Decoded frames time */
+static uint32_t GetFramesLoad(const CanMetricsData* metrics) {
+    const uint32_t can_busy_time_now = metrics->busy_time;
+    const uint32_t cpu_cycles_now = GetCpuCycles();
+    const uint32_t can_busy_time_period = can_busy_time_now - can_busy_time_prev;
+    const uint32_t cpu_cycles_period = cpu_cycles_now - frames_cpu_cycles_prev;
+    can_busy_time_prev = can_busy_time_now;
+    frames_cpu_cycles_prev = cpu_cycles_now;
+    return CalcPercent(can_busy_time_period, cpu_cycles_period);
+}
+
+static uint32_t can_decoder_cycles_prev = 0;
+static uint32_t decoder_busy_time_prev = 0;
+
+/* CPU ticks of the decoder per bit of the decoded frames. At full load it must stay below the bit time */
+static uint32_t GetDecoderCost(const CanMetricsData* metrics) {
+    const uint32_t cycles_period = metrics->decoder_cycles - can_decoder_cycles_prev;
+    const uint32_t busy_time_period = metrics->busy_time - decoder_busy_time_prev;
+    can_decoder_cycles_prev = metrics->decoder_cycles;
+    decoder_busy_time_prev = metrics->busy_time;
+    return (busy_time_period == 0u)
+               ? 0u
+               : (uint32_t)(((uint64_t)cycles_period * (CPU_FREQ / can_bitrate)) / busy_time_period);
+}
+
+static uint32_t can_decoded_frames_prev = 0;
+static uint32_t can_received_frames_prev = 0;
+
+/* Frames decoded from the edges but not received by bxCAN, percent. With the focus filters only the wanted frames
+ * are compared, the received ones after the frame ring */
+static uint32_t GetRxLoss(const CanMetricsData* metrics) {
+#if CAN_FILTER_FOCUS != 0u
+    const uint32_t decoded_now = metrics->wanted_frames;
+    const uint32_t received_now = metrics->rx_wanted_frames;
+#else
+    const uint32_t decoded_now = metrics->frames;
+    const uint32_t received_now = metrics->rx_read_frames;
+#endif
+    const uint32_t decoded = decoded_now - can_decoded_frames_prev;
+    const uint32_t received = received_now - can_received_frames_prev;
+    can_decoded_frames_prev = decoded_now;
+    can_received_frames_prev = received_now;
+    if (received >= decoded) {
+        return 0u;
+    }
+    return CalcPercent(decoded - received, decoded);
+}
+
+static uint32_t can_error_frames_prev = 0;
+static uint32_t can_error_time_prev = 0;
+static uint32_t errors_cpu_cycles_prev = 0;
+
+/* Error frames per second and error time in percent, separate from the good frames load */
+static void GetErrors(const CanMetricsData* metrics, uint32_t* per_second, uint32_t* percent) {
+    const uint32_t cpu_cycles_now = GetCpuCycles();
+    const uint32_t cpu_cycles_period = cpu_cycles_now - errors_cpu_cycles_prev;
+    const uint32_t can_error_frames_period = metrics->error_frames - can_error_frames_prev;
+    const uint32_t can_error_time_period = metrics->error_time - can_error_time_prev;
+    can_error_frames_prev = metrics->error_frames;
+    can_error_time_prev = metrics->error_time;
+    errors_cpu_cycles_prev = cpu_cycles_now;
+    *per_second = (cpu_cycles_period == 0u)
+                      ? 0u
+                      : (uint32_t)(((uint64_t)can_error_frames_period * CPU_FREQ) / cpu_cycles_period);
+    *percent = CalcPercent(can_error_time_period, cpu_cycles_period);
+}
+#endif
+
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+static uint32_t can_dominant_time_prev = 0;
+static uint32_t cpu_cycles_prev = 0;
+
+/* Dominant duty cycle */
+static uint32_t GetGatedLoad(void) {
+    const uint32_t can_dominant_time_now = CanGatedGetTime(&can_gated);
+    const uint32_t cpu_cycles_now = GetCpuCycles();
+    const uint32_t can_dominant_time_period = can_dominant_time_now - can_dominant_time_prev;
+    const uint32_t cpu_cycles_period = cpu_cycles_now - cpu_cycles_prev;
+    can_dominant_time_prev = can_dominant_time_now;
+    cpu_cycles_prev = cpu_cycles_now;
+    return CalcPercent(can_dominant_time_period, cpu_cycles_period);
+}
+#endif
+
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_RX
+static uint32_t can_rx_busy_time_prev = 0;
+static uint32_t rx_cpu_cycles_prev = 0;
+
+/* Received frames time, without the error frames and the frames lost by the receiver */
+static uint32_t GetRxLoad(const CanMetricsData* metrics) {
+    const uint32_t cpu_cycles_now = GetCpuCycles();
+    const uint32_t can_busy_time_period = metrics->rx_busy_time - can_rx_busy_time_prev;
+    const uint32_t cpu_cycles_period = cpu_cycles_now - rx_cpu_cycles_prev;
+    can_rx_busy_time_prev = metrics->rx_busy_time;
+    rx_cpu_cycles_prev = cpu_cycles_now;
+    return CalcPercent(can_busy_time_period, cpu_cycles_period);
+}
+#endif
+
 void MyMain(void) {
     uint8_t* screen = NULL;
     EnableDwt();
+    CanMetricsInit(&can_metrics);
+    CanStatusInit(&can_status);
+    CanGlitchInit(&can_glitch, CPU_FREQ / CAN_BITRATE, CAN_GLITCH_MIN_WIDTH_PERCENT);
+    CanLoadInit(&can_load, (CPU_FREQ / CAN_BITRATE) * CAN_PAYLOAD_BITS);
     if (Mt12232aInit(&mt12232a, &mt12232a_config) == false) {
         Error_Handler();
     }
+    CanHistoryInit(&can_history);
     screen = Mt12232aGetScreenBuffer(&mt12232a);
     assert(screen != NULL);
 
@@ -76,35 +1186,108 @@ void MyMain(void) {
     context.width = MT12232A_WIDTH;
     context.height = MT12232A_HEIGHT;
 
-    CAN_FilterTypeDef can_filter_config;
-    can_filter_config.FilterBank = 0;
-    can_filter_config.FilterMode = CAN_FILTERMODE_IDMASK;
-    can_filter_config.FilterScale = CAN_FILTERSCALE_32BIT;
-    can_filter_config.FilterIdHigh = 0x0000;
-    can_filter_config.FilterIdLow = 0x0000;
-    can_filter_config.FilterMaskIdHigh = 0x0000;
-    can_filter_config.FilterMaskIdLow = 0x0000;
-    can_filter_config.FilterFIFOAssignment = CAN_RX_FIFO0;
-    can_filter_config.FilterActivation = ENABLE;
-    can_filter_config.SlaveStartFilterBank = 14;
-    HAL_CAN_ConfigFilter(&hcan, &can_filter_config);
+    ConfigCanFilters();
 
+    CanFrameRingInit(&can_frame_ring);
+    CanIdTableInit(&can_id_table);
+    CanTopInit(&can_top);
+    CanScheduleInit(&can_schedule, GetCpuCycles());
+    CanPayloadInit(&can_payload);
+    CanSignalValuesInit(&can_signal_values);
+#if CAN_TRIGGER != 0u
+    CanTriggerInit(&can_trigger);
+    if ((CAN_TRIGGER_KEY_MASK != 0u) || (CAN_TRIGGER_DATA_MASK != 0u)) {
+        CanTriggerSetRule(&can_trigger, 0u, CAN_TRIGGER_KEY, CAN_TRIGGER_KEY_MASK, CAN_TRIGGER_DATA,
+                          CAN_TRIGGER_DATA_MASK);
+    }
+    CanTriggerArm(&can_trigger);
+#endif
+#if CAN_J1939 != 0u
+    CanJ1939Init(&can_j1939, MS_TO_CPU_TICKS(CAN_J1939_TP_TIMEOUT_MS));
+#endif
+#if CAN_ISOTP != 0u
+    CanIsoTpInit(&can_isotp, MS_TO_CPU_TICKS(CAN_ISOTP_TIMEOUT_MS), MS_TO_CPU_TICKS(CAN_ISOTP_PAIR_TIMEOUT_MS));
+#endif
+#if CAN_CANOPEN != 0u
+    CanOpenInit(&can_open, MS_TO_CPU_TICKS(1u));
+#endif
+    schedule_cpu_cycles_prev = GetCpuCycles();
+    CanRxInit(&can_rx);
     HAL_CAN_Start(&hcan);
-    HAL_CAN_ActivateNotification(&hcan, CAN_IT_RX_FIFO0_MSG_PENDING);
+    HAL_CAN_ActivateNotification(&hcan, CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO1_MSG_PENDING |
+                                             CAN_IT_RX_FIFO0_OVERRUN | CAN_IT_RX_FIFO1_OVERRUN);
+    /* MX_CAN_Init enables the FIFO 0 interrupt only */
+    HAL_NVIC_SetPriority(CAN1_RX1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(CAN1_RX1_IRQn);
+
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_CAPTURE
+    HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+    CanDecoderInit(&can_decoder, CPU_FREQ / CAN_BITRATE, OnDecodedFrame, NULL);
+    CanGapsInit(&can_gaps, CPU_FREQ / CAN_BITRATE);
+    CanCaptureInit(&can_capture);
+#else
+    CanGovernorInit(&can_governor, MS_TO_CPU_TICKS(CAN_GOVERNOR_WINDOW_MS), CAN_GOVERNOR_MAX_PERCENT,
+                    CAN_GOVERNOR_TARGET_PERCENT, GetCpuCycles());
+    can_governor_started = true;
+#endif
+#if CAN_AUTOBAUD != 0u
+    CanAutobaudInit(&can_autobaud, CPU_FREQ);
+#endif
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+    frames_cpu_cycles_prev = GetCpuCycles();
+    errors_cpu_cycles_prev = frames_cpu_cycles_prev;
+#endif
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+    CanGatedInit(&can_gated);
+    cpu_cycles_prev = GetCpuCycles();
+#endif
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_RX
+    rx_cpu_cycles_prev = GetCpuCycles();
+#endif
 
     // TODO(Any): Logo
     // DrawText(&context, &font_8x16, i % 16u, i / 16u, MT12232A_WIDTH, (i % 16u) + 1u, "Hello world!");
 
+    uint32_t display_updates = 0u;
     for (;;) {
+        const DisplayPage page = (DisplayPage)((display_updates / CAN_DISPLAY_PAGE_UPDATES) % DISPLAY_PAGES_COUNT);
+        const uint32_t page_update = display_updates % CAN_DISPLAY_PAGE_UPDATES;
+#if CAN_TRIGGER != 0u
+        const uint32_t page_visit = display_updates / (CAN_DISPLAY_PAGE_UPDATES * DISPLAY_PAGES_COUNT);
+#endif
+        display_updates++;
+
         /* Info */
-        const uint32_t can_active_time_now = can_active_time;
-        const uint32_t can_inactive_time_now = can_inactive_time;
-        const uint32_t can_active_time_period = can_active_time_now - can_active_time_prev;
-        const uint32_t can_inactive_time_period = can_inactive_time_now - can_inactive_time_prev;
-        const uint32_t can_time_period = (can_active_time_period + can_inactive_time_period);
-        can_active_time_prev = can_active_time_now;
-        can_inactive_time_prev = can_inactive_time_now;
-        const uint32_t value = ((can_active_time_period * 100u) + can_time_period - 1u) / can_time_period;
+        CanMetricsData metrics;
+        CanMetricsRead(&can_metrics, &metrics);
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+        const uint32_t value = GetGatedLoad();
+        const uint32_t compare_value = GetEdgesLoad(&metrics);
+#elif CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+        /* Both keep their periods, the edges stand in while the decoder is off */
+        const uint32_t frames_value = GetFramesLoad(&metrics);
+        const uint32_t edges_value = GetEdgesLoad(&metrics);
+        const uint32_t value = can_decoder_enabled ? frames_value : edges_value;
+        uint32_t error_frames_per_second = 0u;
+        uint32_t error_percent = 0u;
+        GetErrors(&metrics, &error_frames_per_second, &error_percent);
+        const uint32_t rx_loss = GetRxLoss(&metrics);
+        const uint32_t decoder_cost = GetDecoderCost(&metrics);
+#elif CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_RX
+        const uint32_t value = GetRxLoad(&metrics);
+#else
+        const uint32_t value = GetEdgesLoad(&metrics);
+#endif
+        const uint32_t schedule_alarm = GetScheduleAlarm(&metrics);
+        const uint32_t rx_cost = GetRxCost(&metrics);
+#if (CAN_TRIGGER != 0u) && (CAN_TRIGGER_LOAD_PERCENT != 0u)
+        if (value >= CAN_TRIGGER_LOAD_PERCENT) {
+            CanTriggerFire(&can_trigger, CAN_TRIGGER_CAUSE_LOAD, GetCpuCycles());
+        }
+#endif
+#if CAN_CANOPEN != 0u
+        const uint32_t lost_node = CanOpenCheck(&can_open, GetCpuCycles64());
+#endif
 
         /* Draw value */
 
@@ -127,35 +1310,123 @@ void MyMain(void) {
         DrawText(&context, &font_8x16, 0, 0, MT12232A_WIDTH - TEXT_WIDTH, 16, info);
 #endif
 
-        /* Draw graph */
+        CanHistoryAdd(&can_history, (value < 100u) ? (uint8_t)value : 100u);
+        if (page == DISPLAY_PAGE_TREND) {
+            DrawTrendPage(&context, page_update);
+        }
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+        if (page == DISPLAY_PAGE_GAPS) {
+            DrawGapsPage(&context, &metrics, page_update, decoder_cost);
+        }
+#endif
+        if (page == DISPLAY_PAGE_TOP) {
+            DrawTopPage(&context, page_update);
+        }
+        if (page == DISPLAY_PAGE_PAYLOAD) {
+            DrawPayloadPage(&context, page_update);
+        }
+        if (page == DISPLAY_PAGE_SIGNALS) {
+            DrawSignalsPage(&context, page_update);
+        }
+#if CAN_FILTER_FOCUS != 0u
+        if (page == DISPLAY_PAGE_FILTER) {
+            DrawFilterPage(&context);
+        }
+#endif
+#if CAN_TRIGGER != 0u
+        if (page == DISPLAY_PAGE_TRIGGER) {
+            DrawTriggerPage(&context, page_visit, page_update);
+        }
+#endif
+#if CAN_J1939 != 0u
+        if (page == DISPLAY_PAGE_J1939) {
+            DrawJ1939Page(&context, page_update);
+        }
+#endif
+#if CAN_ISOTP != 0u
+        if (page == DISPLAY_PAGE_ISOTP) {
+            DrawIsoTpPage(&context, page_update);
+        }
+#endif
+#if CAN_CANOPEN != 0u
+        if (page == DISPLAY_PAGE_CANOPEN) {
+            DrawCanOpenPage(&context, page_update);
+        }
+#endif
+        if (page == DISPLAY_PAGE_LOAD) {
+            DrawGraph(screen);
+
+            /* CPU ticks per received frame in the second half of the page time, in the top left corner */
+            const bool rx_cost_shown = (page_update >= (CAN_DISPLAY_PAGE_UPDATES / 2u)) && (rx_cost != 0u);
+            if (rx_cost_shown) {
+                char rx_cost_text[8];
+                (void)snprintf(rx_cost_text, sizeof(rx_cost_text), "R%u", (unsigned)rx_cost);
+                DrawText(&context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, rx_cost_text);
+            }
 
-#define GRAPH_HEIGHT (32u)
-        uint8_t value32 = ((uint16_t)(value * GRAPH_HEIGHT) + 99u) / 100u;
-        if (value32 > GRAPH_HEIGHT) {
-            value32 = GRAPH_HEIGHT;
-        }
-        const uint32_t mask = (uint64_t)0xFFFFFFFFu << (32u - value32);
-
-        uint32_t graph_address = GRAPH_X + (GRAPH_Y / MT12232A_POINTS_IN_BYTE) * MT12232A_WIDTH;
-        // TODO(Any): Loop
-        (void)memmove(&screen[graph_address], &screen[graph_address + 1u], GRAPH_WIDTH - 1u);
-        graph_address += MT12232A_WIDTH;
-        (void)memmove(&screen[graph_address], &screen[graph_address + 1u], GRAPH_WIDTH - 1u);
-        graph_address += MT12232A_WIDTH;
-        (void)memmove(&screen[graph_address], &screen[graph_address + 1u], GRAPH_WIDTH - 1u);
-        graph_address += MT12232A_WIDTH;
-        (void)memmove(&screen[graph_address], &screen[graph_address + 1u], GRAPH_WIDTH - 1u);
-
-        // TODO(Any): Loop
-        size_t screen_addr = ((GRAPH_Y / MT12232A_POINTS_IN_BYTE) * MT12232A_WIDTH) + GRAPH_X + GRAPH_WIDTH - 1u;
-        screen[screen_addr] = mask;
-        screen[screen_addr + MT12232A_WIDTH] = mask >> 8u;
-        screen[screen_addr + (MT12232A_WIDTH * 2u)] = mask >> 16u;
-        screen[screen_addr + (MT12232A_WIDTH * 3u)] = mask >> 24u;
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_GATED
+            /* EXTI estimate over the graph for comparison */
+            if (!rx_cost_shown) {
+                char compare_text[8];
+                (void)snprintf(compare_text, sizeof(compare_text), "E%u", (unsigned)compare_value);
+                DrawText(&context, &font_8x16, 0, 0, 32, 16, compare_text);
+            }
+#endif
+
+#if CAN_EDGE_SOURCE == CAN_EDGE_SOURCE_EXTI
+            /* Sampled under an interrupt storm, the load may be off by up to 100 - coverage percent */
+            if (metrics.sampling_coverage < 100u) {
+                char sampled_text[8];
+                (void)snprintf(sampled_text, sizeof(sampled_text), "S%u%%", (unsigned)metrics.sampling_coverage);
+                DrawText(&context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, sampled_text);
+            }
+#endif
+
+#if CAN_LOAD_BACKEND == CAN_LOAD_BACKEND_FRAMES
+            /* Frames lost by the receiver, over the receive cost */
+            if (rx_loss != 0u) {
+                char loss_text[8];
+                (void)snprintf(loss_text, sizeof(loss_text), "L%u%%", (unsigned)rx_loss);
+                DrawText(&context, &font_8x16, 0, 0, GRAPH_WIDTH, 16, loss_text);
+            }
+
+            /* Errors over the graph, only while they happen */
+            if (error_frames_per_second != 0u) {
+                char error_text[16];
+                (void)snprintf(error_text, sizeof(error_text), "E%u%% %u/s", (unsigned)error_percent,
+                               (unsigned)error_frames_per_second);
+                DrawText(&context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, error_text);
+            }
+
+            /* The bit rate is above CAN_DECODER_MAX_BITRATE, the load is from the edges */
+            if (!can_decoder_enabled) {
+                DrawText(&context, &font_8x16, 0, 16, GRAPH_WIDTH, 16, "EDGES");
+            }
+#endif
+
+            /* Periodic identifiers out of schedule, in the top right corner of the graph */
+            if (schedule_alarm != 0u) {
+                char schedule_text[8];
+                (void)snprintf(schedule_text, sizeof(schedule_text), "T%u/s",
+                               (unsigned)((schedule_alarm < 99u) ? schedule_alarm : 99u));
+                DrawText(&context, &font_8x16, GRAPH_WIDTH - SCHEDULE_TEXT_WIDTH, 0, SCHEDULE_TEXT_WIDTH, 16,
+                         schedule_text);
+            }
+
+#if CAN_CANOPEN != 0u
+            /* A CANopen node without a heartbeat, in the bottom right corner of the graph */
+            if (lost_node != 0u) {
+                char heartbeat_text[8];
+                (void)snprintf(heartbeat_text, sizeof(heartbeat_text), "H%u!", (unsigned)lost_node);
+                DrawText(&context, &font_8x16, GRAPH_WIDTH - HEARTBEAT_TEXT_WIDTH, 16, HEARTBEAT_TEXT_WIDTH, 16,
+                         heartbeat_text);
+            }
+#endif
+        }
 
         if (Mt12232aUpdateImage(&mt12232a) == false) {
             Error_Handler();
         }
-        HAL_Delay(100u);
+        WaitAndReadEdges(100u);
     }
 }
@@ -4,5 +4,12 @@
 
 #pragma once
 
+#include <stdbool.h>
+
 void GpioA15IrqHandler(void);
+void Tim2IrqHandler(void);
+void SysTickIrqHandler(void);
+bool CanRx0IrqHandler(void);
+void CanRx1IrqHandler(void);
+void CanRxIrqExit(void);
 void MyMain(void);